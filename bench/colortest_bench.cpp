@@ -0,0 +1,567 @@
+/******************************************************************************
+ * @file    bench/colortest_bench.cpp
+ * @project ColorTestSDL2
+ * @brief   Microbenchmarks for the quantization and lighting hot paths
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "convert.hpp"
+#include "dither.hpp"
+#include "lighting.hpp"
+#include "lighting_simd.hpp"
+#include "palette_simd.hpp"
+#include "palette_tree.hpp"
+#include "quantizer.hpp"
+
+namespace
+{
+
+struct BenchImage
+{
+    std::string name;
+    SDL_Surface* surface;
+};
+
+struct BenchResult
+{
+    std::string benchmark;
+    std::string image;
+    int w;
+    int h;
+    size_t runs;
+    double ns_per_pixel;
+    double stddev_ns_per_pixel;
+    double mpix_per_second;
+};
+
+// Keep timing each case until both limits are reached
+constexpr double MIN_SECONDS = 0.25;
+constexpr size_t MIN_RUNS = 5;
+constexpr size_t MAX_RUNS = 200;
+
+// findClosestPaletteEntry is slow, so only time it on a sample of each image
+constexpr size_t CLOSEST_SAMPLE_PIXELS = 256 * 1024;
+
+SDL_Surface* createSourceSurface(int w, int h)
+{
+    return SDL_CreateRGBSurfaceWithFormat(0, w, h, 24, SDL_PIXELFORMAT_BGR24);
+}
+
+void setPixel(SDL_Surface* surface, int x, int y, uint8_t r, uint8_t g, uint8_t b)
+{
+    uint8_t* pixel = static_cast<uint8_t*>(surface->pixels) + (static_cast<size_t>(y) * surface->pitch) + (x * 3);
+    pixel[0] = b;
+    pixel[1] = g;
+    pixel[2] = r;
+}
+
+SDL_Surface* makeGradient(int w, int h)
+{
+    SDL_Surface* surface = createSourceSurface(w, h);
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x++)
+        {
+            setPixel(surface, x, y,
+                     static_cast<uint8_t>((x * 255) / std::max(1, w - 1)),
+                     static_cast<uint8_t>((y * 255) / std::max(1, h - 1)),
+                     static_cast<uint8_t>(((x + y) * 255) / std::max(1, w + h - 2)));
+        }
+    }
+    return surface;
+}
+
+SDL_Surface* makeNoise(int w, int h)
+{
+    SDL_Surface* surface = createSourceSurface(w, h);
+    std::mt19937 rng(1234);
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x++)
+        {
+            uint32_t value = rng();
+            setPixel(surface, x, y, value >> 16, value >> 8, value);
+        }
+    }
+    return surface;
+}
+
+/**
+ * @brief Blocks of a few dozen colors, like typical pixel art
+ */
+SDL_Surface* makeFlat(int w, int h)
+{
+    SDL_Surface* surface = createSourceSurface(w, h);
+    std::mt19937 rng(5678);
+    std::vector<uint32_t> colors(48);
+    for(uint32_t& color : colors) { color = rng(); }
+
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x++)
+        {
+            uint32_t color = colors[((x / 16) * 7 + (y / 16) * 13) % colors.size()];
+            setPixel(surface, x, y, color >> 16, color >> 8, color);
+        }
+    }
+    return surface;
+}
+
+/**
+ * @brief Times fn until MIN_SECONDS and MIN_RUNS are both reached
+ */
+BenchResult measure(
+        const std::string& benchmark,
+        const BenchImage& image,
+        size_t pixels,
+        const std::function<void()>& fn
+)
+{
+    fn(); // Warm up caches and lazily built tables
+
+    std::vector<double> samples;
+    double total = 0;
+    while(samples.size() < MAX_RUNS && (samples.size() < MIN_RUNS || total < MIN_SECONDS))
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        samples.push_back(seconds * 1e9 / pixels);
+        total += seconds;
+    }
+
+    double mean = 0;
+    for(double sample : samples) { mean += sample; }
+    mean /= samples.size();
+
+    double variance = 0;
+    for(double sample : samples) { variance += (sample - mean) * (sample - mean); }
+    variance /= samples.size();
+
+    return {
+            benchmark,
+            image.name,
+            image.surface->w,
+            image.surface->h,
+            samples.size(),
+            mean,
+            std::sqrt(variance),
+            1e3 / mean
+    };
+}
+
+void printResult(const BenchResult& result)
+{
+    std::cout << std::left << std::setw(38) << result.benchmark
+              << std::setw(28) << result.image
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << result.ns_per_pixel << " ns/px"
+              << " +/- " << std::setw(6) << result.stddev_ns_per_pixel
+              << std::setw(10) << result.mpix_per_second << " MPix/s"
+              << "  (" << result.runs << " runs)" << std::endl;
+}
+
+std::string escapeJSON(const std::string& text)
+{
+    std::string escaped;
+    for(char c : text)
+    {
+        if(c == '"' || c == '\\') { escaped += '\\'; }
+        escaped += c;
+    }
+    return escaped;
+}
+
+int writeJSON(const std::string& path, unsigned threads, const std::vector<BenchResult>& results)
+{
+    std::ofstream file(path);
+    if(!file) { return 1; }
+
+    file << "{\n  \"nearest_kernel\": \"" << nearestKernelName() << "\",\n"
+         << "  \"lighting_kernel\": \"" << lightingKernelName() << "\",\n"
+         << "  \"threads\": " << threads << ",\n"
+         << "  \"results\": [\n";
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& result = results[i];
+        file << std::setprecision(6)
+             << "    {\"benchmark\": \"" << escapeJSON(result.benchmark) << "\""
+             << ", \"image\": \"" << escapeJSON(result.image) << "\""
+             << ", \"w\": " << result.w
+             << ", \"h\": " << result.h
+             << ", \"runs\": " << result.runs
+             << ", \"ns_per_pixel\": " << result.ns_per_pixel
+             << ", \"stddev_ns_per_pixel\": " << result.stddev_ns_per_pixel
+             << ", \"mpix_per_second\": " << result.mpix_per_second
+             << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    file << "  ]\n}\n";
+    return file ? 0 : 1;
+}
+
+/**
+ * @brief Checks a lighting kernel against lightIndex() for every index and
+ * state, at every alignment and a spread of lengths, so tails are covered.
+ * @return Number of mismatches
+ */
+size_t verifyLighting(LightingKernel kernel)
+{
+    std::vector<uint8_t> source(1024 + 64);
+    std::vector<uint8_t> dest(source.size());
+    for(size_t i = 0; i < source.size(); i++) { source[i] = static_cast<uint8_t>(i * 7 + (i >> 8)); }
+
+    size_t mismatches = 0;
+    for(int state = 0; state < LIGHTING_STATES; state++)
+    {
+        int dark_level = state / 2;
+        bool underwater = (state % 2) != 0;
+
+        for(size_t offset = 0; offset < 64; offset++)
+        {
+            for(size_t count : { 0, 1, 15, 16, 17, 31, 33, 63, 64, 127, 129, 256, 1000 })
+            {
+                kernel(source.data() + offset, dest.data() + offset, count, dark_level, underwater);
+                for(size_t i = offset; i < offset + count; i++)
+                {
+                    if(dest[i] != lightIndex(source[i], dark_level, underwater)) { mismatches++; }
+                }
+            }
+        }
+
+        // In place, as updateLighting never does but convertBMPFile does
+        std::vector<uint8_t> in_place = source;
+        kernel(in_place.data(), in_place.data(), in_place.size(), dark_level, underwater);
+        for(size_t i = 0; i < source.size(); i++)
+        {
+            if(in_place[i] != lightIndex(source[i], dark_level, underwater)) { mismatches++; }
+        }
+    }
+
+    return mismatches;
+}
+
+/**
+ * @brief Checks every lighting kernel the CPU can run, not just the one in
+ * use, so a fast machine still covers the fallbacks
+ * @return true if they all agree with lightIndex()
+ */
+bool verifyLightingKernels()
+{
+    bool passed = true;
+    for(const LightingKernelInfo& info : supportedLightingKernels())
+    {
+        size_t mismatches = verifyLighting(info.kernel);
+        if(mismatches != 0)
+        {
+            std::cerr << info.name << " lighting kernel disagrees with lightIndex() "
+                      << mismatches << " times" << std::endl;
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+void runImage(
+        const ConversionContext& context,
+        const ConversionContext& dedup_context,
+        const ConversionContext& oklab_context,
+        const std::vector<std::unique_ptr<ConversionContext>>& dither_contexts,
+        const PaletteTree& tree,
+        const BenchImage& image,
+        std::vector<BenchResult>& results
+)
+{
+    SDL_Surface* source = image.surface;
+    size_t pixels = static_cast<size_t>(source->w) * source->h;
+
+    SDL_Surface* indexed = SDL_CreateRGBSurfaceWithFormat(0, source->w, source->h, 8, SDL_PIXELFORMAT_INDEX8);
+    SDL_Surface* lit = SDL_CreateRGBSurfaceWithFormat(0, source->w, source->h, 8, SDL_PIXELFORMAT_INDEX8);
+    if(indexed == nullptr || lit == nullptr)
+    {
+        std::cerr << "Could not allocate " << image.name << ": " << SDL_GetError() << std::endl;
+        SDL_FreeSurface(indexed);
+        SDL_FreeSurface(lit);
+        return;
+    }
+
+    // Sample pixels for the full-palette search
+    std::vector<SDL_Color> sample;
+    const uint8_t* source_pixels = static_cast<const uint8_t*>(source->pixels);
+    size_t step = std::max<size_t>(1, pixels / CLOSEST_SAMPLE_PIXELS);
+    size_t width = static_cast<size_t>(source->w);
+    for(size_t i = 0; i < pixels; i += step)
+    {
+        // Rows are padded, so go by pitch rather than a flat index
+        size_t offset = ((i / width) * source->pitch) + ((i % width) * 3);
+        sample.push_back({ source_pixels[offset + 2], source_pixels[offset + 1], source_pixels[offset] });
+    }
+
+    volatile uint8_t sink = 0;
+    results.push_back(measure("findClosestPaletteEntry", image, sample.size(), [&] {
+        uint8_t accumulator = 0;
+        for(SDL_Color color : sample) { accumulator ^= context.findClosestPaletteEntry(color); }
+        sink = sink ^ accumulator;
+    }));
+    printResult(results.back());
+
+    results.push_back(measure("PaletteTree::nearest", image, sample.size(), [&] {
+        uint8_t accumulator = 0;
+        for(SDL_Color color : sample) { accumulator ^= tree.nearest(color); }
+        sink = sink ^ accumulator;
+    }));
+    printResult(results.back());
+
+    size_t visited = 0;
+    for(SDL_Color color : sample) { tree.nearest(color, &visited); }
+    std::cout << "    tree compared " << (static_cast<double>(visited) / sample.size())
+              << " of " << palette.size() << " entries per color" << std::endl;
+
+    for(const QuantizerVariant& variant : quantizerVariants())
+    {
+        results.push_back(measure(std::string("PaletteQuantizer/") + variant.name, image, sample.size(), [&] {
+            uint8_t accumulator = 0;
+            for(SDL_Color color : sample) { accumulator ^= variant.nearest(color); }
+            sink = sink ^ accumulator;
+        }));
+        printResult(results.back());
+    }
+
+    results.push_back(measure("convertSurfaceToIndex", image, pixels, [&] {
+        context.convertSurfaceToIndex(source, indexed);
+    }));
+    printResult(results.back());
+
+    results.push_back(measure("convertSurfaceToIndex/dedup", image, pixels, [&] {
+        dedup_context.convertSurfaceToIndex(source, indexed);
+    }));
+    printResult(results.back());
+
+    results.push_back(measure("convertSurfaceToIndex/oklab", image, pixels, [&] {
+        oklab_context.convertSurfaceToIndex(source, indexed);
+    }));
+    printResult(results.back());
+
+    for(const auto& dither_context : dither_contexts)
+    {
+        std::string name = std::string("convertSurfaceToIndex/") + ditherModeName(dither_context->options().dither);
+        results.push_back(measure(name, image, pixels, [&] {
+            dither_context->convertSurfaceToIndex(source, indexed);
+        }));
+        printResult(results.back());
+    }
+
+    // The cases below read the weighted RGB result
+    context.convertSurfaceToIndex(source, indexed);
+
+    // The same image as an already indexed source, with its palette reversed
+    // so the remap is not a plain copy
+    SDL_Surface* paletted = SDL_CreateRGBSurfaceWithFormat(0, source->w, source->h, 8, SDL_PIXELFORMAT_INDEX8);
+    if(paletted != nullptr)
+    {
+        SDL_Color reversed[256];
+        for(size_t i = 0; i < 256; i++) { reversed[i] = palette[255 - i]; }
+        SDL_SetPaletteColors(paletted->format->palette, reversed, 0, 256);
+
+        for(int y = 0; y < source->h; y++)
+        {
+            const uint8_t* indexed_row = static_cast<const uint8_t*>(indexed->pixels) + (y * indexed->pitch);
+            uint8_t* paletted_row = static_cast<uint8_t*>(paletted->pixels) + (y * paletted->pitch);
+            for(int x = 0; x < source->w; x++) { paletted_row[x] = 255 - indexed_row[x]; }
+        }
+
+        results.push_back(measure("convertSurfaceToIndex/indexed", image, pixels, [&] {
+            context.convertSurfaceToIndex(paletted, lit);
+        }));
+        printResult(results.back());
+
+        SDL_FreeSurface(paletted);
+    }
+
+    // The fused dark level and underwater pass behind updateLighting()
+    const uint8_t* indexed_pixels = static_cast<const uint8_t*>(indexed->pixels);
+    uint8_t* lit_pixels = static_cast<uint8_t*>(lit->pixels);
+    size_t surface_size = static_cast<size_t>(indexed->pitch) * indexed->h;
+    results.push_back(measure("applyLighting", image, pixels, [&] {
+        applyLighting(indexed_pixels, lit_pixels, surface_size, 3, true);
+    }));
+    printResult(results.back());
+
+    // The table lookup applyLighting used before it was vectorized
+    results.push_back(measure("remapIndices", image, pixels, [&] {
+        remapIndices(indexed_pixels, lit_pixels, surface_size, lightingTable(3, true));
+    }));
+    printResult(results.back());
+
+    SDL_FreeSurface(indexed);
+    SDL_FreeSurface(lit);
+}
+
+}
+
+
+
+int main(int argc, char** argv)
+{
+    std::string json_path;
+    std::vector<std::string> image_paths;
+    bool quick = false;
+    bool verify_only = false;
+    bool synthetic = true;
+    unsigned threads = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--json" && i + 1 < argc)
+        {
+            json_path = argv[++i];
+        } else if(arg == "--image" && i + 1 < argc)
+        {
+            image_paths.push_back(argv[++i]);
+        } else if(arg == "--threads" && i + 1 < argc)
+        {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if(arg == "--quick")
+        {
+            quick = true;
+        } else if(arg == "--no-synthetic")
+        {
+            synthetic = false;
+        } else if(arg == "--verify")
+        {
+            verify_only = true;
+        } else
+        {
+            std::cerr << "Usage: colortest_bench [--json out.json] [--image in.bmp]... "
+                      << "[--threads N] [--quick] [--no-synthetic] [--verify]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Correctness only, for a quick check after touching a kernel
+    if(verify_only)
+    {
+        if(!verifyLightingKernels()) { return 1; }
+        std::cout << "All lighting kernels match lightIndex()" << std::endl;
+        return 0;
+    }
+
+    // Every variant runs on the same workers
+    ThreadPool pool(threads);
+
+    ConversionOptions dedup_options;
+    dedup_options.dedup_colors = true;
+
+    ConversionContext context(ConversionOptions(), &pool);
+    ConversionContext dedup_context(dedup_options, &pool);
+
+    ConversionOptions oklab_options;
+    oklab_options.metric = ColorMetric::OKLab;
+    ConversionContext oklab_context(oklab_options, &pool);
+
+    PaletteTree tree;
+
+    std::vector<std::unique_ptr<ConversionContext>> dither_contexts;
+    for(DitherMode mode : { DitherMode::Bayer, DitherMode::BlueNoise, DitherMode::FloydSteinberg, DitherMode::Atkinson })
+    {
+        ConversionOptions dither_options;
+        dither_options.dither = mode;
+        dither_contexts.push_back(std::make_unique<ConversionContext>(dither_options, &pool));
+    }
+
+    bool ready = context.init() == 0 && dedup_context.init() == 0 && oklab_context.init() == 0
+                 && tree.build(palette.data(), palette.size()) == 0;
+    for(const auto& dither_context : dither_contexts)
+    {
+        ready = ready && dither_context->init() == 0;
+    }
+
+    if(!ready)
+    {
+        std::cerr << "Could not prepare conversion: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Nearest kernel: " << nearestKernelName()
+              << ", lighting kernel: " << lightingKernelName()
+              << ", threads: " << pool.threadCount() << std::endl;
+
+    if(!verifyLightingKernels()) { return 1; }
+
+    std::vector<BenchResult> results;
+
+    if(synthetic)
+    {
+        std::vector<std::pair<int, int>> sizes = {
+                { 64, 64 }, { 256, 256 }, { 1024, 1024 }, { 1920, 1080 }
+        };
+        if(!quick)
+        {
+            sizes.push_back({ 3840, 2160 });
+            sizes.push_back({ 7680, 4320 });
+        }
+
+        const std::vector<std::pair<std::string, SDL_Surface* (*)(int, int)>> generators = {
+                { "gradient", makeGradient },
+                { "noise", makeNoise },
+                { "flat", makeFlat }
+        };
+
+        for(const auto& size : sizes)
+        {
+            for(const auto& generator : generators)
+            {
+                std::string name = generator.first + "_"
+                                   + std::to_string(size.first) + "x" + std::to_string(size.second);
+
+                SDL_Surface* surface = generator.second(size.first, size.second);
+                if(surface == nullptr) { continue; }
+
+                runImage(context, dedup_context, oklab_context, dither_contexts, tree, { name, surface }, results);
+                SDL_FreeSurface(surface);
+            }
+        }
+    }
+
+    for(const std::string& path : image_paths)
+    {
+        SDL_Surface* surface = SDL_LoadBMP(path.c_str());
+        if(surface == nullptr || surface->format->BitsPerPixel != 24)
+        {
+            std::cerr << "Skipping " << path << ": not a 24-bit bitmap" << std::endl;
+            SDL_FreeSurface(surface);
+            continue;
+        }
+
+        runImage(context, dedup_context, oklab_context, dither_contexts, tree, { path, surface }, results);
+        SDL_FreeSurface(surface);
+    }
+
+    if(!json_path.empty() && writeJSON(json_path, pool.threadCount(), results) != 0)
+    {
+        std::cerr << "Could not write " << json_path << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
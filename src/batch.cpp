@@ -0,0 +1,195 @@
+/******************************************************************************
+ * @file    src/batch.cpp
+ * @project ColorTestSDL2
+ * @brief   Headless conversion of many bitmaps at once
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "batch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+bool isBitmap(const fs::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return extension == ".bmp";
+}
+
+/**
+ * @brief Matches a name against a pattern of literal characters, * and ?
+ */
+bool matchesGlob(const std::string& name, const std::string& pattern)
+{
+    size_t n = 0;
+    size_t p = 0;
+    size_t star = std::string::npos;
+    size_t star_match = 0;
+
+    while(n < name.size())
+    {
+        if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+        {
+            n++;
+            p++;
+        } else if(p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            star_match = n;
+        } else if(star != std::string::npos)
+        {
+            // Let the last * swallow one more character
+            p = star + 1;
+            n = ++star_match;
+        } else
+        {
+            return false;
+        }
+    }
+
+    while(p < pattern.size() && pattern[p] == '*') { p++; }
+
+    return p == pattern.size();
+}
+
+}
+
+
+
+std::vector<std::string> collectBatchFiles(const std::vector<std::string>& inputs)
+{
+    std::vector<std::string> files;
+    std::error_code error;
+
+    for(const std::string& input : inputs)
+    {
+        fs::path path(input);
+
+        if(input.find_first_of("*?") != std::string::npos)
+        {
+            fs::path directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+            std::string pattern = path.filename().string();
+
+            for(const fs::directory_entry& entry : fs::directory_iterator(directory, error))
+            {
+                if(entry.is_regular_file(error) && matchesGlob(entry.path().filename().string(), pattern))
+                {
+                    files.push_back(entry.path().string());
+                }
+            }
+        } else if(fs::is_directory(path, error))
+        {
+            for(const fs::directory_entry& entry : fs::directory_iterator(path, error))
+            {
+                if(entry.is_regular_file(error) && isBitmap(entry.path()))
+                {
+                    files.push_back(entry.path().string());
+                }
+            }
+        } else
+        {
+            files.push_back(input);
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    return files;
+}
+
+
+
+int convertBatch(
+        const ConversionContext& context,
+        const std::vector<std::string>& inputs,
+        const std::string& output_dir,
+        int dark_level,
+        bool underwater
+)
+{
+    std::vector<std::string> files = collectBatchFiles(inputs);
+    if(files.empty())
+    {
+        std::cerr << "No bitmaps found." << std::endl;
+        return 1;
+    }
+
+    // Outputs are named after their inputs, so two inputs with one name
+    // would race to write the same file
+    std::vector<fs::path> outputs;
+    std::map<fs::path, size_t> first_with_name;
+    bool clashes = false;
+    for(size_t i = 0; i < files.size(); i++)
+    {
+        fs::path name = fs::path(files[i]).filename();
+        auto inserted = first_with_name.emplace(name, i);
+        if(!inserted.second)
+        {
+            std::cerr << files[inserted.first->second] << " and " << files[i]
+                      << " would both be written to " << name.string() << std::endl;
+            clashes = true;
+        }
+        outputs.push_back(fs::path(output_dir) / name);
+    }
+    if(clashes) { return 1; }
+
+    std::error_code error;
+    fs::create_directories(output_dir, error);
+    if(error)
+    {
+        std::cerr << "Could not create " << output_dir << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    ThreadPool& pool = context.pool();
+    std::atomic<size_t> converted{0};
+    std::atomic<size_t> total_pixels{0};
+    std::mutex log_mutex;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // One task per file. Each conversion splits its own tiles on the same
+    // pool, so a huge image is finished by every idle worker.
+    pool.parallelFor(files.size(), [&](size_t i) {
+        ConversionStats stats;
+
+        int err = context.convertBMPFile(files[i], outputs[i].string(), dark_level, underwater, &stats);
+        if(err != 0)
+        {
+            // SDL keeps errors per thread
+            std::lock_guard<std::mutex> lock(log_mutex);
+            std::cerr << "Could not convert " << files[i] << ": " << SDL_GetError() << std::endl;
+            return;
+        }
+
+        converted.fetch_add(1);
+        total_pixels.fetch_add(stats.pixels);
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    seconds = std::max(seconds, 1e-9);
+
+    std::cout << "Converted " << converted.load() << " of " << files.size()
+              << " images in " << seconds << " s on " << pool.threadCount() << " threads: "
+              << (converted.load() / seconds) << " images/s, "
+              << (total_pixels.load() / seconds / 1e6) << " MPix/s" << std::endl;
+
+    return converted.load() == files.size() ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+/******************************************************************************
+ * @file    src/batch.hpp
+ * @project ColorTestSDL2
+ * @brief   Headless conversion of many bitmaps at once
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_BATCH_HPP
+#define COLORTESTSDL2_BATCH_HPP
+
+#include <string>
+#include <vector>
+#include "convert.hpp"
+
+/**
+ * @brief Expands files, directories and globs into a sorted list of bitmaps.
+ * Directories are not searched recursively. Globs may use * and ? in the
+ * file name only.
+ */
+std::vector<std::string> collectBatchFiles(const std::vector<std::string>& inputs);
+
+/**
+ * @brief Converts every bitmap matched by inputs into output_dir, and prints
+ * throughput. Files are spread across the context's pool, and each file's
+ * tiles share the same workers. Nothing is converted if two inputs share a
+ * file name, since both would be written to the same output.
+ * @return 0 if every file converted, 1 otherwise
+ */
+int convertBatch(
+        const ConversionContext& context,
+        const std::vector<std::string>& inputs,
+        const std::string& output_dir,
+        int dark_level,
+        bool underwater
+);
+
+#endif //COLORTESTSDL2_BATCH_HPP
@@ -0,0 +1,555 @@
+/******************************************************************************
+ * @file    src/bmp_stream.cpp
+ * @project ColorTestSDL2
+ * @brief   Converts bitmaps a band of rows at a time, in bounded memory
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "bmp_stream.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
+#include <vector>
+#include "convert.hpp"
+#include "lighting.hpp"
+#include "mapped_file.hpp"
+#include "palette.hpp"
+
+namespace
+{
+
+constexpr size_t FILE_HEADER_SIZE = 14;
+constexpr size_t INFO_HEADER_SIZE = 40;
+constexpr uint32_t BI_RGB = 0;
+constexpr uint32_t BI_BITFIELDS = 3;
+
+/**
+ * @brief Called with each converted band, in file order
+ * @param band First Index8 row, padded to 4 bytes
+ * @param first_row Index of the first row in file order
+ * @param rows Rows in the band
+ * @return 0 to keep going, 1 to stop
+ */
+using BandSink = std::function<int(uint8_t* band, size_t first_row, size_t rows)>;
+
+uint32_t readLE(const uint8_t* bytes, size_t size)
+{
+    uint32_t value = 0;
+    for(size_t i = 0; i < size; i++)
+    {
+        value |= static_cast<uint32_t>(bytes[i]) << (i * 8);
+    }
+    return value;
+}
+
+void writeLE(uint8_t* bytes, uint32_t value, size_t size)
+{
+    for(size_t i = 0; i < size; i++)
+    {
+        bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+/**
+ * @brief Kernel for a streamable bitmap. Bitmap pixels are stored BGR(X).
+ */
+PixelLayout bitmapLayout(const BMPHeader& header)
+{
+    return header.bits_per_pixel == 32 ? PixelLayout::BGRX32 : PixelLayout::BGR24;
+}
+
+/**
+ * @brief Image row, counted from the top, of a row in file order
+ */
+size_t imageRow(const BMPHeader& header, size_t file_row)
+{
+    return header.top_down ? file_row : static_cast<size_t>(header.height) - 1 - file_row;
+}
+
+size_t indexedRowBytes(size_t width)
+{
+    return (width + 3) & ~static_cast<size_t>(3);
+}
+
+int parseBMPHeader(std::istream& file, BMPHeader& header)
+{
+    uint8_t bytes[FILE_HEADER_SIZE + INFO_HEADER_SIZE];
+    if(!file.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+    {
+        SDL_SetError("Bitmap header is truncated.");
+        return 1;
+    }
+
+    if(bytes[0] != 'B' || bytes[1] != 'M')
+    {
+        SDL_SetError("File is not a bitmap.");
+        return 1;
+    }
+
+    // Older OS/2 headers are smaller, and left to SDL
+    if(readLE(bytes + 14, 4) < INFO_HEADER_SIZE)
+    {
+        SDL_SetError("Unsupported bitmap header.");
+        return 1;
+    }
+
+    int32_t width = static_cast<int32_t>(readLE(bytes + 18, 4));
+    int32_t height = static_cast<int32_t>(readLE(bytes + 22, 4));
+    if(width <= 0 || height == 0 || height == std::numeric_limits<int32_t>::min())
+    {
+        SDL_SetError("Bitmap has an invalid size.");
+        return 1;
+    }
+
+    header.width = width;
+    header.height = std::abs(height);
+    header.top_down = height < 0;
+    header.bits_per_pixel = static_cast<uint16_t>(readLE(bytes + 28, 2));
+    header.compression = readLE(bytes + 30, 4);
+    header.pixel_offset = readLE(bytes + 10, 4);
+    header.row_bytes = ((static_cast<size_t>(width) * header.bits_per_pixel + 31) / 32) * 4;
+
+    // Masks follow a plain info header, and sit in the same place in the
+    // larger ones
+    if(header.compression == BI_BITFIELDS)
+    {
+        uint8_t masks[12];
+        if(!file.read(reinterpret_cast<char*>(masks), sizeof(masks)))
+        {
+            SDL_SetError("Bitmap header is truncated.");
+            return 1;
+        }
+
+        header.red_mask = readLE(masks, 4);
+        header.green_mask = readLE(masks + 4, 4);
+        header.blue_mask = readLE(masks + 8, 4);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Converts and hands off every band of a mapped bitmap. Rows are
+ * converted where they sit in the mapping, without being copied.
+ * @return 0 on success, 1 on failure
+ */
+int convertMappedBands(
+        const ConversionContext& context,
+        const MappedFile& file,
+        const BMPHeader& header,
+        const BandSink& sink,
+        const CancelToken* cancel
+)
+{
+    size_t width = static_cast<size_t>(header.width);
+    size_t height = static_cast<size_t>(header.height);
+    size_t dest_pitch = indexedRowBytes(width);
+    size_t rows_per_band = std::max<size_t>(1, STREAM_BAND_BYTES / header.row_bytes);
+    size_t band_count = (height + rows_per_band - 1) / rows_per_band;
+
+    if(header.pixel_offset > file.size() || (file.size() - header.pixel_offset) / header.row_bytes < height)
+    {
+        SDL_SetError("Bitmap pixel data is truncated.");
+        return 1;
+    }
+
+    std::vector<uint8_t> dest_band(rows_per_band * dest_pitch, 0);
+    file.adviseSequential();
+
+    for(size_t band = 0; band < band_count; band++)
+    {
+        size_t first_row = band * rows_per_band;
+        size_t rows = std::min(rows_per_band, height - first_row);
+        size_t band_offset = header.pixel_offset + first_row * header.row_bytes;
+
+        // Have the next band read in while this one converts
+        file.prefetch(band_offset + rows * header.row_bytes, rows_per_band * header.row_bytes);
+
+        context.convertRows(
+                file.data() + band_offset, header.row_bytes, bitmapLayout(header),
+                dest_band.data(), dest_pitch,
+                width, rows,
+                nullptr, cancel, imageRow(header, first_row), !header.top_down
+        );
+
+        if(isCancelled(cancel))
+        {
+            SDL_SetError("Conversion was cancelled.");
+            return 1;
+        }
+
+        // Done with these rows, so they need not stay resident
+        file.release(band_offset, rows * header.row_bytes);
+
+        if(sink(dest_band.data(), first_row, rows) != 0) { return 1; }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Reads, converts and hands off every band of a streamable bitmap.
+ * The next band is read while the current one converts.
+ * @return 0 on success, 1 on failure
+ */
+int convertReadBands(
+        const ConversionContext& context,
+        const std::string& path,
+        const BMPHeader& header,
+        const BandSink& sink,
+        const CancelToken* cancel
+)
+{
+    size_t width = static_cast<size_t>(header.width);
+    size_t height = static_cast<size_t>(header.height);
+    size_t dest_pitch = indexedRowBytes(width);
+    size_t rows_per_band = std::max<size_t>(1, STREAM_BAND_BYTES / header.row_bytes);
+    size_t band_count = (height + rows_per_band - 1) / rows_per_band;
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(header.pixel_offset));
+    if(!file)
+    {
+        SDL_SetError("Bitmap pixel data is missing.");
+        return 1;
+    }
+
+    std::vector<uint8_t> source_bands[2];
+    source_bands[0].resize(rows_per_band * header.row_bytes);
+    source_bands[1].resize(rows_per_band * header.row_bytes);
+    std::vector<uint8_t> dest_band(rows_per_band * dest_pitch, 0);
+
+    auto readBand = [&](size_t band) {
+        size_t rows = std::min(rows_per_band, height - band * rows_per_band);
+        std::vector<uint8_t>& buffer = source_bands[band % 2];
+        return static_cast<bool>(file.read(
+                reinterpret_cast<char*>(buffer.data()),
+                static_cast<std::streamsize>(rows * header.row_bytes)
+        ));
+    };
+
+    // Declared after the buffers, so an early return waits for the read
+    // before they are freed
+    std::future<bool> pending = std::async(std::launch::async, readBand, 0);
+
+    for(size_t band = 0; band < band_count; band++)
+    {
+        if(!pending.get())
+        {
+            SDL_SetError("Bitmap pixel data is truncated.");
+            return 1;
+        }
+
+        if(band + 1 < band_count)
+        {
+            pending = std::async(std::launch::async, readBand, band + 1);
+        }
+
+        size_t first_row = band * rows_per_band;
+        size_t rows = std::min(rows_per_band, height - first_row);
+
+        context.convertRows(
+                source_bands[band % 2].data(), header.row_bytes, bitmapLayout(header),
+                dest_band.data(), dest_pitch,
+                width, rows,
+                nullptr, cancel, imageRow(header, first_row), !header.top_down
+        );
+
+        if(isCancelled(cancel))
+        {
+            SDL_SetError("Conversion was cancelled.");
+            return 1;
+        }
+
+        if(sink(dest_band.data(), first_row, rows) != 0) { return 1; }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Converts and hands off every band of a streamable bitmap, straight
+ * from a mapping when the file can be mapped, and through reads otherwise.
+ * @param cancel Checked between tiles. Null if the job cannot be cancelled.
+ * @return 0 on success, 1 on failure
+ */
+int convertBands(
+        const ConversionContext& context,
+        const std::string& path,
+        const BMPHeader& header,
+        const BandSink& sink,
+        const CancelToken* cancel
+)
+{
+    if(!context.canConvertInBands())
+    {
+        SDL_SetError("Error diffusion cannot be converted a band at a time.");
+        return 1;
+    }
+
+    MappedFile mapped;
+    if(mapped.open(path) == 0)
+    {
+        return convertMappedBands(context, mapped, header, sink, cancel);
+    }
+
+    return convertReadBands(context, path, header, sink, cancel);
+}
+
+/**
+ * @brief Writes the headers and palette of an uncompressed 8-bit bitmap.
+ * All 256 entries are written, so lit indices past the count stay valid.
+ * @return 0 on success, 1 on failure
+ */
+int writeIndexedBMPHeader(std::ostream& file, const BMPHeader& source, const ColorPalette& colors)
+{
+    size_t palette_size = colors.colors.size() * 4;
+    uint64_t pixel_offset = FILE_HEADER_SIZE + INFO_HEADER_SIZE + palette_size;
+    uint64_t image_size = static_cast<uint64_t>(indexedRowBytes(source.width)) * source.height;
+    uint64_t file_size = pixel_offset + image_size;
+
+    // Sizes past 4 GiB do not fit. Readers go by the dimensions instead.
+    constexpr uint64_t MAX_SIZE = std::numeric_limits<uint32_t>::max();
+    if(image_size > MAX_SIZE) { image_size = 0; }
+    if(file_size > MAX_SIZE) { file_size = 0; }
+
+    std::vector<uint8_t> bytes(pixel_offset, 0);
+    bytes[0] = 'B';
+    bytes[1] = 'M';
+    writeLE(&bytes[2], static_cast<uint32_t>(file_size), 4);
+    writeLE(&bytes[10], static_cast<uint32_t>(pixel_offset), 4);
+
+    int32_t height = source.top_down ? -source.height : source.height;
+    writeLE(&bytes[14], INFO_HEADER_SIZE, 4);
+    writeLE(&bytes[18], static_cast<uint32_t>(source.width), 4);
+    writeLE(&bytes[22], static_cast<uint32_t>(height), 4);
+    writeLE(&bytes[26], 1, 2);
+    writeLE(&bytes[28], 8, 2);
+    writeLE(&bytes[30], BI_RGB, 4);
+    writeLE(&bytes[34], static_cast<uint32_t>(image_size), 4);
+    writeLE(&bytes[46], static_cast<uint32_t>(colors.colors.size()), 4);
+
+    // Palette entries are stored BGR0
+    for(size_t i = 0; i < colors.colors.size(); i++)
+    {
+        uint8_t* entry = &bytes[FILE_HEADER_SIZE + INFO_HEADER_SIZE + i * 4];
+        entry[0] = colors.colors[i].b;
+        entry[1] = colors.colors[i].g;
+        entry[2] = colors.colors[i].r;
+    }
+
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file ? 0 : 1;
+}
+
+/**
+ * @brief Deletes an unfinished output file. Keeps the error already set.
+ */
+void removePartial(const std::string& path)
+{
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+}
+
+/**
+ * @brief Reads the header of a bitmap, if it can be streamed
+ * @return 0 on success, 1 on failure
+ */
+int readStreamableBMPHeader(const std::string& path, BMPHeader& header)
+{
+    if(readBMPHeader(path, header) != 0) { return 1; }
+
+    if(!isStreamableBMP(header))
+    {
+        SDL_SetError("Only uncompressed 24-bit and 32-bit bitmaps can be streamed.");
+        return 1;
+    }
+
+    return 0;
+}
+
+}
+
+
+
+/**
+ * @brief Reads the file and info headers of a bitmap
+ * @return 0 on success, 1 on failure
+ */
+int readBMPHeader(const std::string& path, BMPHeader& header)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+    {
+        SDL_SetError("Could not open %s.", path.c_str());
+        return 1;
+    }
+
+    return parseBMPHeader(file, header);
+}
+
+
+
+/**
+ * @brief Whether the streaming reader can handle this bitmap: uncompressed
+ * 24-bit, or 32-bit with the usual BGRX byte order.
+ */
+bool isStreamableBMP(const BMPHeader& header)
+{
+    if(header.bits_per_pixel == 24) { return header.compression == BI_RGB; }
+    if(header.bits_per_pixel != 32) { return false; }
+
+    return header.compression == BI_RGB
+           || (header.compression == BI_BITFIELDS
+               && header.red_mask == 0x00FF0000
+               && header.green_mask == 0x0000FF00
+               && header.blue_mask == 0x000000FF);
+}
+
+
+
+/**
+ * @brief Converts a bitmap to an indexed 8-bit bitmap one band of rows at a
+ * time. Rows are written in the order they are read, so the whole image is
+ * never in memory. Files that can be memory mapped are converted in place.
+ * @param input Path to a streamable bitmap
+ * @param output Path to write the indexed bitmap to. It is written under
+ * another name and renamed once complete, so it may be the input.
+ * @param dark_level 0 to MAX_DARK_LEVEL
+ * @param underwater Apply underwater lighting
+ * @param stats Filled in on success, if not null
+ * @return 0 on success, 1 on failure
+ */
+int streamConvertBMP(
+        const ConversionContext& context,
+        const std::string& input,
+        const std::string& output,
+        int dark_level,
+        bool underwater,
+        ConversionStats* stats
+)
+{
+    BMPHeader header;
+    if(readStreamableBMPHeader(input, header) != 0) { return 1; }
+
+    // Rows are written while the input is still being read, so writing to
+    // output directly would destroy the input when they are the same file.
+    // A partly written file is never left at output either.
+    std::string partial = output + ".partial";
+    std::ofstream dest(partial, std::ios::binary | std::ios::trunc);
+    if(!dest || writeIndexedBMPHeader(dest, header, context.currentPalette()) != 0)
+    {
+        SDL_SetError("Could not write %s.", output.c_str());
+        dest.close();
+        removePartial(partial);
+        return 1;
+    }
+
+    size_t width = static_cast<size_t>(header.width);
+    size_t dest_pitch = indexedRowBytes(width);
+
+    // Both files keep the same row order, so bands go straight out
+    int err = convertBands(context, input, header, [&](uint8_t* band, size_t, size_t rows) {
+        for(size_t y = 0; y < rows; y++)
+        {
+            uint8_t* row = band + (y * dest_pitch);
+            applyLighting(row, row, width, dark_level, underwater);
+        }
+
+        dest.write(reinterpret_cast<const char*>(band), static_cast<std::streamsize>(rows * dest_pitch));
+        if(!dest)
+        {
+            SDL_SetError("Could not write %s.", output.c_str());
+            return 1;
+        }
+        return 0;
+    }, nullptr);
+
+    dest.close();
+    if(err == 0 && !dest)
+    {
+        SDL_SetError("Could not write %s.", output.c_str());
+        err = 1;
+    }
+
+    if(err == 0)
+    {
+        std::error_code rename_error;
+        std::filesystem::rename(partial, output, rename_error);
+        if(rename_error)
+        {
+            SDL_SetError("Could not replace %s: %s", output.c_str(), rename_error.message().c_str());
+            err = 1;
+        }
+    }
+
+    if(err != 0)
+    {
+        removePartial(partial);
+        return 1;
+    }
+
+    if(stats != nullptr)
+    {
+        stats->pixels = width * header.height;
+        stats->unique_colors = 0;
+    }
+
+    return 0;
+}
+
+
+
+/**
+ * @brief Loads a streamable bitmap straight into a new Index8
+ * surface, without holding the true color image in memory.
+ * @param cancel Stops the load between tiles once set. Fails if it did.
+ * @return The surface, or nullptr on failure. The caller owns it.
+ */
+SDL_Surface* loadIndexedBMP(const ConversionContext& context, const std::string& path, const CancelToken* cancel)
+{
+    BMPHeader header;
+    if(readStreamableBMPHeader(path, header) != 0) { return nullptr; }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(
+            0,
+            header.width, header.height,
+            8, SDL_PIXELFORMAT_INDEX8
+    );
+    if(surface == nullptr) { return nullptr; }
+
+    if(SDL_SetPaletteColors(surface->format->palette, context.currentPalette().colors.data(), 0, 256) != 0)
+    {
+        SDL_FreeSurface(surface);
+        return nullptr;
+    }
+
+    size_t width = static_cast<size_t>(header.width);
+    size_t dest_pitch = indexedRowBytes(width);
+    uint8_t* pixels = static_cast<uint8_t*>(surface->pixels);
+
+    int err = convertBands(context, path, header, [&](uint8_t* band, size_t first_row, size_t rows) {
+        for(size_t y = 0; y < rows; y++)
+        {
+            size_t file_row = first_row + y;
+            size_t surface_row = header.top_down ? file_row : header.height - 1 - file_row;
+            std::copy_n(band + (y * dest_pitch), width, pixels + (surface_row * surface->pitch));
+        }
+        return 0;
+    }, cancel);
+
+    if(err != 0)
+    {
+        SDL_FreeSurface(surface);
+        return nullptr;
+    }
+
+    return surface;
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+ * @file    src/bmp_stream.hpp
+ * @project ColorTestSDL2
+ * @brief   Converts bitmaps a band of rows at a time, in bounded memory
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_BMP_STREAM_HPP
+#define COLORTESTSDL2_BMP_STREAM_HPP
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "thread_pool.hpp"
+
+class ConversionContext;
+struct ConversionStats;
+
+// Source bytes read per band. Two bands are in flight at a time, one being
+// read while the other converts.
+constexpr size_t STREAM_BAND_BYTES = 4 * 1024 * 1024;
+
+/**
+ * @brief The parts of a bitmap header the streaming reader needs
+ */
+struct BMPHeader
+{
+    int32_t width = 0;
+    int32_t height = 0;       // Always positive
+    bool top_down = false;    // Rows are stored top to bottom
+    uint16_t bits_per_pixel = 0;
+    uint32_t compression = 0;
+    uint64_t pixel_offset = 0;
+    size_t row_bytes = 0;     // Including padding to 4 bytes
+
+    // Only read for BI_BITFIELDS
+    uint32_t red_mask = 0;
+    uint32_t green_mask = 0;
+    uint32_t blue_mask = 0;
+};
+
+/**
+ * @brief Reads the file and info headers of a bitmap
+ * @return 0 on success, 1 on failure
+ */
+int readBMPHeader(const std::string& path, BMPHeader& header);
+
+/**
+ * @brief Whether the streaming reader can handle this bitmap: uncompressed
+ * 24-bit, or 32-bit with the usual BGRX byte order.
+ */
+bool isStreamableBMP(const BMPHeader& header);
+
+/**
+ * @brief Converts a bitmap to an indexed 8-bit bitmap one band of rows at a
+ * time. Rows are written in the order they are read, so the whole image is
+ * never in memory. Files that can be memory mapped are converted in place.
+ * @param input Path to a streamable bitmap
+ * @param output Path to write the indexed bitmap to. It is written under
+ * another name and renamed once complete, so it may be the input.
+ * @param dark_level 0 to MAX_DARK_LEVEL
+ * @param underwater Apply underwater lighting
+ * @param stats Filled in on success, if not null
+ * @return 0 on success, 1 on failure
+ */
+int streamConvertBMP(
+        const ConversionContext& context,
+        const std::string& input,
+        const std::string& output,
+        int dark_level,
+        bool underwater,
+        ConversionStats* stats = nullptr
+);
+
+/**
+ * @brief Loads a streamable bitmap straight into a new Index8
+ * surface, without holding the true color image in memory.
+ * @param cancel Stops the load between tiles once set. Fails if it did.
+ * @return The surface, or nullptr on failure. The caller owns it.
+ */
+SDL_Surface* loadIndexedBMP(const ConversionContext& context, const std::string& path, const CancelToken* cancel = nullptr);
+
+#endif //COLORTESTSDL2_BMP_STREAM_HPP
@@ -0,0 +1,180 @@
+/******************************************************************************
+ * @file    src/color_metric.cpp
+ * @project ColorTestSDL2
+ * @brief   Distance metrics for matching colors to the palette
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "color_metric.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+
+/**
+ * @brief sRGB transfer curve, decoded once per channel value
+ */
+const std::array<float, 256>& linearTable()
+{
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> values{};
+        for(size_t i = 0; i < values.size(); i++)
+        {
+            double encoded = i / 255.0;
+            double linear = (encoded <= 0.04045)
+                            ? encoded / 12.92
+                            : std::pow((encoded + 0.055) / 1.055, 2.4);
+            values[i] = static_cast<float>(linear);
+        }
+        return values;
+    }();
+
+    return table;
+}
+
+/**
+ * @brief Cube root of a value from 0 to 1, to within about 2e-7. std::cbrt
+ * was most of the cost of a conversion. Three Newton steps from a guess made
+ * by dividing the exponent bits are enough.
+ */
+float cubeRoot(float value)
+{
+    if(value <= 0.0f) { return 0.0f; }
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits = (bits / 3) + 709921077u;
+
+    float root;
+    std::memcpy(&root, &bits, sizeof(root));
+    for(int i = 0; i < 3; i++)
+    {
+        root = ((2.0f * root) + (value / (root * root))) * (1.0f / 3.0f);
+    }
+
+    return root;
+}
+
+/**
+ * @brief Cone responses of a color, cube rooted. Every coefficient is
+ * positive, so each one only grows as a channel grows.
+ */
+void coneResponses(SDL_Color color, float& l, float& m, float& s)
+{
+    const std::array<float, 256>& linear = linearTable();
+    float r = linear[color.r];
+    float g = linear[color.g];
+    float b = linear[color.b];
+
+    l = cubeRoot((0.4122214708f * r) + (0.5363325363f * g) + (0.0514459929f * b));
+    m = cubeRoot((0.2119034982f * r) + (0.6806995451f * g) + (0.1073969566f * b));
+    s = cubeRoot((0.0883024619f * r) + (0.2817188376f * g) + (0.6299787005f * b));
+}
+
+OKLabColor mixOKLab(float l, float m, float s)
+{
+    return {
+            (0.2104542553f * l) + (0.7936177850f * m) - (0.0040720468f * s),
+            (1.9779984951f * l) - (2.4285922050f * m) + (0.4505937099f * s),
+            (0.0259040371f * l) + (0.7827717662f * m) - (0.8086757660f * s)
+    };
+}
+
+/**
+ * @brief Range of weight * value, for value in [low, high]
+ */
+void scaledRange(float weight, float low, float high, float& min, float& max)
+{
+    min += std::min(weight * low, weight * high);
+    max += std::max(weight * low, weight * high);
+}
+
+}
+
+/**
+ * @brief Converts an sRGB color to OKLab. The transfer curve comes from a
+ * 256 entry table, so this is a few multiplies and three cube roots.
+ * @note Every OKLab search must use this, or lookups will disagree.
+ */
+OKLabColor toOKLab(SDL_Color color)
+{
+    float l, m, s;
+    coneResponses(color, l, m, s);
+    return mixOKLab(l, m, s);
+}
+
+
+
+/**
+ * @brief OKLab box holding every color in an sRGB box. The transform is
+ * monotonic up to the final mix, so the corners of the sRGB box bound it.
+ * @param low Lowest value of each channel
+ * @param high Highest value of each channel
+ */
+void oklabBounds(SDL_Color low, SDL_Color high, OKLabColor& min, OKLabColor& max)
+{
+    float low_l, low_m, low_s;
+    float high_l, high_m, high_s;
+    coneResponses(low, low_l, low_m, low_s);
+    coneResponses(high, high_l, high_m, high_s);
+
+    // The mix has negative weights, so each term takes whichever end is lower
+    min = { 0, 0, 0 };
+    max = { 0, 0, 0 };
+
+    scaledRange(0.2104542553f, low_l, high_l, min.l, max.l);
+    scaledRange(0.7936177850f, low_m, high_m, min.l, max.l);
+    scaledRange(-0.0040720468f, low_s, high_s, min.l, max.l);
+
+    scaledRange(1.9779984951f, low_l, high_l, min.a, max.a);
+    scaledRange(-2.4285922050f, low_m, high_m, min.a, max.a);
+    scaledRange(0.4505937099f, low_s, high_s, min.a, max.a);
+
+    scaledRange(0.0259040371f, low_l, high_l, min.b, max.b);
+    scaledRange(0.7827717662f, low_m, high_m, min.b, max.b);
+    scaledRange(-0.8086757660f, low_s, high_s, min.b, max.b);
+}
+
+
+
+/**
+ * @brief Name used on the command line and in logs
+ */
+const char* colorMetricName(ColorMetric metric)
+{
+    switch(metric)
+    {
+    case ColorMetric::WeightedRGB: return "rgb";
+    case ColorMetric::OKLab: return "oklab";
+    }
+
+    return "unknown";
+}
+
+
+
+/**
+ * @brief Parses a colorMetricName()
+ * @return 0 on success, 1 if the name is unknown
+ */
+int parseColorMetric(const std::string& name, ColorMetric& metric)
+{
+    for(ColorMetric candidate : { ColorMetric::WeightedRGB, ColorMetric::OKLab })
+    {
+        if(name == colorMetricName(candidate))
+        {
+            metric = candidate;
+            return 0;
+        }
+    }
+
+    SDL_SetError("Unknown color metric: %s", name.c_str());
+    return 1;
+}
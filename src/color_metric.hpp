@@ -0,0 +1,73 @@
+/******************************************************************************
+ * @file    src/color_metric.hpp
+ * @project ColorTestSDL2
+ * @brief   Distance metrics for matching colors to the palette
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_COLOR_METRIC_HPP
+#define COLORTESTSDL2_COLOR_METRIC_HPP
+
+#include <SDL2/SDL.h>
+#include <string>
+
+/**
+ * @brief How "closest palette entry" is measured
+ */
+enum class ColorMetric
+{
+    WeightedRGB, // paletteDistance(). Fast, but poor on dark blues and skin tones.
+    OKLab        // Euclidean distance in OKLab, which tracks perceived difference
+};
+
+/**
+ * @brief A color in OKLab. l is lightness from 0 to 1, a and b are roughly
+ * -0.4 to 0.4.
+ */
+struct OKLabColor
+{
+    float l;
+    float a;
+    float b;
+};
+
+/**
+ * @brief Converts an sRGB color to OKLab. The transfer curve comes from a
+ * 256 entry table, so this is a few multiplies and three cube roots.
+ * @note Every OKLab search must use this, or lookups will disagree.
+ */
+OKLabColor toOKLab(SDL_Color color);
+
+/**
+ * @brief Squared euclidean distance between two OKLab colors
+ */
+inline float oklabDistance(OKLabColor x, OKLabColor y)
+{
+    return ((x.l - y.l) * (x.l - y.l))
+           + ((x.a - y.a) * (x.a - y.a))
+           + ((x.b - y.b) * (x.b - y.b));
+}
+
+/**
+ * @brief OKLab box holding every color in an sRGB box. The transform is
+ * monotonic up to the final mix, so the corners of the sRGB box bound it.
+ * @param low Lowest value of each channel
+ * @param high Highest value of each channel
+ */
+void oklabBounds(SDL_Color low, SDL_Color high, OKLabColor& min, OKLabColor& max);
+
+/**
+ * @brief Name used on the command line and in logs
+ */
+const char* colorMetricName(ColorMetric metric);
+
+/**
+ * @brief Parses a colorMetricName()
+ * @return 0 on success, 1 if the name is unknown
+ */
+int parseColorMetric(const std::string& name, ColorMetric& metric);
+
+#endif //COLORTESTSDL2_COLOR_METRIC_HPP
@@ -0,0 +1,51 @@
+/******************************************************************************
+ * @file    src/color_set.cpp
+ * @project ColorTestSDL2
+ * @brief   Open-addressing hash set of 24-bit colors
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "color_set.hpp"
+
+namespace
+{
+
+constexpr size_t MIN_CAPACITY = 1024;
+
+}
+
+
+
+void ColorSet::clear(size_t expected)
+{
+    size_t capacity = MIN_CAPACITY;
+    int bits = 10;
+    while(capacity < expected * 2)
+    {
+        capacity *= 2;
+        bits++;
+    }
+
+    keys.assign(capacity, EMPTY);
+    count = 0;
+    mask = capacity - 1;
+    shift = 32 - bits;
+}
+
+
+
+void ColorSet::grow()
+{
+    std::vector<uint32_t> old_keys;
+    old_keys.swap(keys);
+
+    clear(old_keys.size());
+
+    for(uint32_t color : old_keys)
+    {
+        if(color != EMPTY) { insert(color); }
+    }
+}
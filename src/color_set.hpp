@@ -0,0 +1,93 @@
+/******************************************************************************
+ * @file    src/color_set.hpp
+ * @project ColorTestSDL2
+ * @brief   Open-addressing hash set of 24-bit colors
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_COLOR_SET_HPP
+#define COLORTESTSDL2_COLOR_SET_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Set of 0xRRGGBB colors with linear probing. Slots only move when the
+ * set grows, so once filling is done callers can keep a value per slot().
+ */
+class ColorSet
+{
+public:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+    ColorSet() { clear(); }
+
+    static uint32_t pack(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+    }
+
+    /**
+     * @brief Empties the set
+     * @param expected Number of colors to make room for up front
+     */
+    void clear(size_t expected = 0);
+
+    void insert(uint32_t color)
+    {
+        size_t index = hash(color);
+        while(keys[index] != color)
+        {
+            if(keys[index] == EMPTY)
+            {
+                keys[index] = color;
+                count++;
+                if(count * 2 > keys.size()) { grow(); }
+                return;
+            }
+            index = (index + 1) & mask;
+        }
+    }
+
+    /**
+     * @brief Slot holding a color. The color must be in the set.
+     */
+    size_t slot(uint32_t color) const
+    {
+        size_t index = hash(color);
+        while(keys[index] != color)
+        {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    size_t size() const { return count; }
+
+    size_t capacity() const { return keys.size(); }
+
+    /**
+     * @brief Color in a slot, or EMPTY
+     */
+    uint32_t at(size_t slot) const { return keys[slot]; }
+
+private:
+    size_t hash(uint32_t color) const
+    {
+        // Fibonacci hashing spreads neighbouring colors across the table
+        return static_cast<size_t>((color * 0x9E3779B1u) >> shift) & mask;
+    }
+
+    void grow();
+
+    std::vector<uint32_t> keys;
+    size_t count = 0;
+    size_t mask = 0;
+    int shift = 32;
+};
+
+#endif //COLORTESTSDL2_COLOR_SET_HPP
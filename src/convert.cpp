@@ -0,0 +1,761 @@
+/******************************************************************************
+ * @file    src/convert.cpp
+ * @project ColorTestSDL2
+ * @brief   Converts true color surfaces to the indexed palette
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "convert.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "bmp_stream.hpp"
+#include "color_set.hpp"
+#include "lighting.hpp"
+
+namespace
+{
+
+/**
+ * @brief Rows per tile, so each tile's source stays in cache
+ */
+size_t rowsPerTile(size_t row_bytes)
+{
+    return std::max<size_t>(1, CONVERSION_TILE_BYTES / std::max<size_t>(1, row_bytes));
+}
+
+uint8_t clampChannel(int value)
+{
+    return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+/**
+ * @brief Error diffusion, with rows running as a wavefront. Each lane takes
+ * the next row in order, and stays far enough behind the row above that no
+ * two rows add error to the same pixel at once. Rows are handed out in
+ * order, so a row only ever waits on rows that are already running.
+ * @param colors Palette the lookup table was built from
+ */
+template<typename Kernel, typename Reader>
+void diffuseErrors(
+        const PaletteLUT& lut,
+        const SDL_Color* colors,
+        ThreadPool& pool,
+        Reader read,
+        const uint8_t* source,
+        size_t source_pitch,
+        uint8_t* dest,
+        size_t dest_pitch,
+        size_t width,
+        size_t rows,
+        const CancelToken* cancel
+)
+{
+    if(rows == 0 || width == 0) { return; }
+
+    // A pixel can only be finished once the row above has passed every
+    // pixel that adds error to it, or to the ones this pixel adds to
+    constexpr size_t lag = Kernel::LEFT + Kernel::RIGHT + 1;
+    constexpr int round = 1 << (Kernel::SHIFT - 1);
+
+    size_t lanes = std::min<size_t>(pool.threadCount(), rows);
+
+    // Error for the rows in flight, padded so taps past the edges land
+    // somewhere harmless
+    size_t slot_count = lanes + Kernel::ROWS + 1;
+    size_t slot_size = (width + Kernel::LEFT + Kernel::RIGHT) * 3;
+    std::vector<int32_t> errors(slot_count * slot_size, 0);
+    auto slot = [&](size_t y) { return errors.data() + ((y % slot_count) * slot_size); };
+
+    // Pixels finished in each row
+    std::vector<std::atomic<size_t>> progress(rows);
+    std::atomic<size_t> next_row{0};
+
+    auto waitFor = [&](size_t y, size_t pixels) {
+        while(progress[y].load(std::memory_order_acquire) < pixels)
+        {
+            if(isCancelled(cancel)) { return false; }
+            std::this_thread::yield();
+        }
+        return true;
+    };
+
+    auto diffuseRow = [&](size_t y) {
+        // The slot furthest ahead is reused from an older row. Wait for that
+        // row to finish, then clear it.
+        size_t ahead = y + Kernel::ROWS;
+        if(ahead >= slot_count && !waitFor(ahead - slot_count, width)) { return false; }
+        std::fill_n(slot(ahead), slot_size, 0);
+
+        const uint8_t* source_row = source + (y * source_pitch);
+        uint8_t* dest_row = dest + (y * dest_pitch);
+
+        // This row's error, then the rows below it
+        std::array<int32_t*, Kernel::ROWS + 1> row_errors;
+        for(size_t dy = 0; dy < row_errors.size(); dy++)
+        {
+            row_errors[dy] = slot(y + dy) + (Kernel::LEFT * 3);
+        }
+
+        for(size_t begin = 0; begin < width; begin += DIFFUSION_BLOCK)
+        {
+            size_t end = std::min(width, begin + DIFFUSION_BLOCK);
+            if(y > 0 && !waitFor(y - 1, std::min(width, end - 1 + lag))) { return false; }
+
+            for(size_t x = begin; x < end; x++)
+            {
+                SDL_Color color = read(source_row, x);
+                const int32_t* error = row_errors[0] + (x * 3);
+                int r = clampChannel(color.r + ((error[0] + round) >> Kernel::SHIFT));
+                int g = clampChannel(color.g + ((error[1] + round) >> Kernel::SHIFT));
+                int b = clampChannel(color.b + ((error[2] + round) >> Kernel::SHIFT));
+
+                uint8_t index = lut.lookup({
+                        static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b), 0xFF
+                });
+                dest_row[x] = index;
+
+                int error_r = r - colors[index].r;
+                int error_g = g - colors[index].g;
+                int error_b = b - colors[index].b;
+                for(const DiffusionTap& tap : Kernel::taps)
+                {
+                    int32_t* target = row_errors[tap.dy] + ((static_cast<int>(x) + tap.dx) * 3);
+                    target[0] += error_r * tap.weight;
+                    target[1] += error_g * tap.weight;
+                    target[2] += error_b * tap.weight;
+                }
+            }
+
+            progress[y].store(end, std::memory_order_release);
+        }
+
+        return true;
+    };
+
+    pool.parallelFor(lanes, [&](size_t) {
+        for(size_t y = next_row++; y < rows; y = next_row++)
+        {
+            if(isCancelled(cancel) || !diffuseRow(y)) { return; }
+        }
+    });
+}
+
+}
+
+ConversionContext::ConversionContext(const ConversionOptions& options, ThreadPool* shared_pool)
+    : settings(options), pool_ptr(shared_pool)
+{
+}
+
+
+
+/**
+ * @brief Creates the pool and builds the lookup tables
+ * @note Call before converting from several threads at a time.
+ * @return 0 on success, 1 on failure
+ */
+int ConversionContext::init()
+{
+    if(pool_ptr == nullptr)
+    {
+        owned_pool = std::make_unique<ThreadPool>(settings.threads);
+        pool_ptr = owned_pool.get();
+    }
+
+    if(!palette_lut.isBuilt())
+    {
+        int err = palette_lut.build(palette_entries.colors.data(), palette_entries.count, settings.metric);
+        if(err != 0) { return 1; }
+    }
+
+    return buildPaletteSearch();
+}
+
+
+
+/**
+ * @brief Switches to another palette. Before init() this only stores it.
+ * After, only the lookup table cells that changed entries matter in are
+ * rebuilt, so tweaking a few entries takes milliseconds.
+ * @note Not safe while a conversion is running on this context.
+ * @param rebuilt_cells Lookup table cells redone, if not null
+ * @return 0 on success, 1 on failure
+ */
+int ConversionContext::setPalette(const ColorPalette& colors, size_t* rebuilt_cells)
+{
+    if(colors.count == 0 || colors.count > colors.colors.size())
+    {
+        SDL_SetError("Palette must have between 1 and 256 entries.");
+        return 1;
+    }
+
+    palette_entries = colors;
+    if(rebuilt_cells != nullptr) { *rebuilt_cells = 0; }
+    if(!palette_lut.isBuilt()) { return 0; }
+
+    int err = palette_lut.update(palette_entries.colors.data(), palette_entries.count, rebuilt_cells);
+    if(err != 0) { return 1; }
+
+    return buildPaletteSearch();
+}
+
+
+
+/**
+ * @brief Rebuilds every search structure besides the lookup table for
+ * the current palette. All of them are small next to the table.
+ * @return 0 on success, 1 on failure
+ */
+int ConversionContext::buildPaletteSearch()
+{
+    const SDL_Color* colors = palette_entries.colors.data();
+    size_t count = palette_entries.count;
+
+    int err = buildPaletteSoA(colors, count, palette_soa);
+    if(err != 0) { return 1; }
+    if(nearest_kernel == nullptr) { nearest_kernel = selectNearestKernel(); }
+
+    err = palette_tree.build(colors, count);
+    if(err != 0) { return 1; }
+
+    for(size_t i = 0; i < count; i++)
+    {
+        palette_lab[i] = toOKLab(colors[i]);
+    }
+
+    // The hand vectorized weighted RGB kernels beat the compiled-in one
+    const QuantizerVariant* variant = findQuantizer(settings.metric, colors, count);
+    bool vector_kernel = settings.metric == ColorMetric::WeightedRGB && nearest_kernel != findNearestScalar;
+    compiled_nearest = (variant != nullptr && !vector_kernel) ? variant->nearest : nullptr;
+
+    // The offsets scale with how far apart the entries are
+    bool ordered_dither = settings.dither != DitherMode::None && !isErrorDiffusion(settings.dither);
+    if(ordered_dither)
+    {
+        err = threshold_map.build(settings.dither, paletteSpread(colors, count));
+        if(err != 0) { return 1; }
+    }
+
+    return 0;
+}
+
+
+
+int ConversionContext::convertSurfaceToIndex(
+        SDL_Surface* source,
+        SDL_Surface* dest,
+        ConversionStats* stats,
+        const CancelToken* cancel
+) const
+{
+    // Lots of error checking
+    if(source == nullptr || dest == nullptr) { return 1; }
+
+    int err;
+
+    if(dest->format->format != SDL_PIXELFORMAT_INDEX8)
+    {
+        SDL_SetError("Dest Surface is not Index8.");
+        return 1;
+    }
+
+    if(source->w != dest->w || source->h != dest->h)
+    {
+        SDL_SetError("Source Surface and Dest Surface resolutions are not equal.");
+        return 1;
+    }
+
+    if(!isReady())
+    {
+        SDL_SetError("Conversion context is not initialized.");
+        return 1;
+    }
+
+    // Formats without a kernel of their own take one trip through SDL
+    PixelLayout layout;
+    SDL_Surface* converted = nullptr;
+    if(pixelLayoutOf(source->format, layout) != 0)
+    {
+        converted = SDL_ConvertSurfaceFormat(source, SDL_PIXELFORMAT_ARGB8888, 0);
+        if(converted == nullptr) { return 1; }
+
+        source = converted;
+        if(pixelLayoutOf(source->format, layout) != 0)
+        {
+            SDL_FreeSurface(converted);
+            SDL_SetError("Source Surface format is not supported.");
+            return 1;
+        }
+    }
+
+    // Short palettes leave the rest black, so stray indices stay in bounds
+    std::array<SDL_Color, 256> source_colors = {};
+    if(layout == PixelLayout::Index8)
+    {
+        const SDL_Palette* source_palette = source->format->palette;
+        std::copy_n(source_palette->colors, std::min(source_palette->ncolors, 256), source_colors.begin());
+    }
+
+    err = SDL_LockSurface(source);
+    if(err != 0) {
+        SDL_UnlockSurface(source);
+        SDL_FreeSurface(converted);
+        return 1;
+    }
+
+    err = SDL_LockSurface(dest);
+    if(err != 0)
+    {
+        SDL_UnlockSurface(source);
+        SDL_UnlockSurface(dest);
+        SDL_FreeSurface(converted);
+        return 1;
+    }
+
+    const uint8_t* source_pixels = static_cast<const uint8_t*>(source->pixels);
+    uint8_t* dest_pixels = static_cast<uint8_t*>(dest->pixels);
+    size_t width = static_cast<size_t>(source->w);
+    size_t height = static_cast<size_t>(source->h);
+
+    size_t unique_colors = 0;
+
+    // Indexed sources have a faster path than deduplicating, and dithered
+    // pixels of the same color can still map to different entries
+    if(settings.dedup_colors && settings.dither == DitherMode::None && layout != PixelLayout::Index8)
+    {
+        unique_colors = quantizeUniqueColors(
+                source_pixels, source->pitch, layout, source_colors.data(),
+                dest_pixels, dest->pitch,
+                width, height,
+                cancel
+        );
+    } else
+    {
+        convertRows(
+                source_pixels, source->pitch, layout,
+                dest_pixels, dest->pitch,
+                width, height,
+                source_colors.data(),
+                cancel
+        );
+    }
+
+    SDL_UnlockSurface(source);
+    SDL_UnlockSurface(dest);
+    SDL_FreeSurface(converted);
+
+    if(isCancelled(cancel))
+    {
+        SDL_SetError("Conversion was cancelled.");
+        return 1;
+    }
+
+    if(stats != nullptr)
+    {
+        stats->pixels = width * height;
+        stats->unique_colors = unique_colors;
+    }
+
+    return 0;
+}
+
+
+
+/**
+ * @brief Quantizes each distinct color once, then remaps pixels through the results.
+ * @param source First source row
+ * @param source_pitch Bytes between source rows
+ * @param layout Source pixel format
+ * @param source_colors 256 entry source palette. Only used by Index8.
+ * @param dest First Index8 row
+ * @param dest_pitch Bytes between dest rows
+ * @param cancel Skips the remaining work once set
+ * @return Number of distinct colors
+ */
+size_t ConversionContext::quantizeUniqueColors(
+        const uint8_t* source,
+        size_t source_pitch,
+        PixelLayout layout,
+        const SDL_Color* source_colors,
+        uint8_t* dest,
+        size_t dest_pitch,
+        size_t width,
+        size_t rows,
+        const CancelToken* cancel
+) const
+{
+    size_t rows_per_tile = rowsPerTile(width * pixelLayoutBytes(layout));
+    size_t tile_count = (rows + rows_per_tile - 1) / rows_per_tile;
+
+    ColorSet unique_colors;
+    withPixelReader(layout, source_colors, [&](auto read) {
+        for(size_t tile = 0; tile < tile_count && !isCancelled(cancel); tile++)
+        {
+            size_t begin = tile * rows_per_tile;
+            size_t end = std::min(rows, begin + rows_per_tile);
+
+            for(size_t y = begin; y < end; y++)
+            {
+                const uint8_t* source_row = source + (y * source_pitch);
+                for(size_t x = 0; x < width; x++)
+                {
+                    SDL_Color color = read(source_row, x);
+                    unique_colors.insert(ColorSet::pack(color.r, color.g, color.b));
+                }
+            }
+        }
+    });
+    if(isCancelled(cancel)) { return 0; }
+
+    // One result per slot. The set is read-only from here on.
+    std::vector<uint8_t> slot_index(unique_colors.capacity());
+
+    size_t slots_per_tile = 4096;
+    size_t slot_tiles = (unique_colors.capacity() + slots_per_tile - 1) / slots_per_tile;
+    pool_ptr->parallelFor(slot_tiles, [&](size_t tile) {
+        if(isCancelled(cancel)) { return; }
+
+        size_t begin = tile * slots_per_tile;
+        size_t end = std::min(unique_colors.capacity(), begin + slots_per_tile);
+
+        for(size_t slot = begin; slot < end; slot++)
+        {
+            uint32_t packed = unique_colors.at(slot);
+            if(packed == ColorSet::EMPTY) { continue; }
+
+            SDL_Color color = {
+                    static_cast<uint8_t>(packed >> 16),
+                    static_cast<uint8_t>(packed >> 8),
+                    static_cast<uint8_t>(packed)
+            };
+            slot_index[slot] = palette_lut.lookup(color);
+        }
+    });
+
+    withPixelReader(layout, source_colors, [&](auto read) {
+        pool_ptr->parallelFor(tile_count, [&](size_t tile) {
+            if(isCancelled(cancel)) { return; }
+
+            size_t begin = tile * rows_per_tile;
+            size_t end = std::min(rows, begin + rows_per_tile);
+
+            for(size_t y = begin; y < end; y++)
+            {
+                const uint8_t* source_row = source + (y * source_pitch);
+                uint8_t* dest_row = dest + (y * dest_pitch);
+
+                for(size_t x = 0; x < width; x++)
+                {
+                    SDL_Color color = read(source_row, x);
+                    dest_row[x] = slot_index[unique_colors.slot(ColorSet::pack(color.r, color.g, color.b))];
+                }
+            }
+        });
+    });
+
+    return unique_colors.size();
+}
+
+
+
+/**
+ * @brief Converts rows of pixels, splitting them across the pool. Each
+ * source format gets its own copy of the loop. Only valid after init().
+ * @param source First source row
+ * @param source_pitch Bytes between source rows
+ * @param layout Source pixel format
+ * @param dest First Index8 row
+ * @param dest_pitch Bytes between dest rows
+ * @param source_colors 256 entry source palette. Only used by Index8.
+ * @param cancel Skips the remaining tiles once set. The caller checks it
+ * afterwards, since dest is left partly written.
+ * @param first_row Row of the image that source starts at, so ordered
+ * dither patterns line up across bands
+ * @param bottom_up Source rows go up the image, as in most bitmap files.
+ * first_row is then the image row of the first source row, and each
+ * later source row is the one above it.
+ */
+void ConversionContext::convertRows(
+        const uint8_t* source,
+        size_t source_pitch,
+        PixelLayout layout,
+        uint8_t* dest,
+        size_t dest_pitch,
+        size_t width,
+        size_t rows,
+        const SDL_Color* source_colors,
+        const CancelToken* cancel,
+        size_t first_row,
+        bool bottom_up
+) const
+{
+    if(isErrorDiffusion(settings.dither))
+    {
+        ditherErrorDiffusion(source, source_pitch, layout, source_colors, dest, dest_pitch, width, rows, cancel);
+        return;
+    }
+
+    if(settings.dither != DitherMode::None)
+    {
+        ditherOrdered(source, source_pitch, layout, source_colors, dest, dest_pitch, width, rows, first_row, bottom_up, cancel);
+        return;
+    }
+
+    size_t rows_per_tile = rowsPerTile(width * pixelLayoutBytes(layout));
+    size_t tile_count = (rows + rows_per_tile - 1) / rows_per_tile;
+
+    // An indexed source only has 256 colors. Match those once, and remap
+    // every pixel through the result.
+    if(layout == PixelLayout::Index8)
+    {
+        IndexRemap remap;
+        for(size_t i = 0; i < remap.size(); i++)
+        {
+            remap[i] = palette_lut.lookup(source_colors[i]);
+        }
+
+        pool_ptr->parallelFor(tile_count, [&](size_t tile) {
+            if(isCancelled(cancel)) { return; }
+
+            size_t begin = tile * rows_per_tile;
+            size_t end = std::min(rows, begin + rows_per_tile);
+
+            for(size_t y = begin; y < end; y++)
+            {
+                remapIndices(source + (y * source_pitch), dest + (y * dest_pitch), width, remap);
+            }
+        });
+        return;
+    }
+
+    withPixelReader(layout, source_colors, [&](auto read) {
+        pool_ptr->parallelFor(tile_count, [&](size_t tile) {
+            if(isCancelled(cancel)) { return; }
+
+            size_t begin = tile * rows_per_tile;
+            size_t end = std::min(rows, begin + rows_per_tile);
+
+            for(size_t y = begin; y < end; y++)
+            {
+                const uint8_t* source_row = source + (y * source_pitch);
+                uint8_t* dest_row = dest + (y * dest_pitch);
+
+                for(size_t x = 0; x < width; x++)
+                {
+                    dest_row[x] = palette_lut.lookup(read(source_row, x));
+                }
+            }
+        });
+    });
+}
+
+
+
+/**
+ * @brief Ordered dithering. Tiles run in any order, like convertRows.
+ * @param first_row Row of the image that source starts at
+ * @param bottom_up Each source row is the image row above the last
+ */
+void ConversionContext::ditherOrdered(
+        const uint8_t* source,
+        size_t source_pitch,
+        PixelLayout layout,
+        const SDL_Color* source_colors,
+        uint8_t* dest,
+        size_t dest_pitch,
+        size_t width,
+        size_t rows,
+        size_t first_row,
+        bool bottom_up,
+        const CancelToken* cancel
+) const
+{
+    size_t rows_per_tile = rowsPerTile(width * pixelLayoutBytes(layout));
+    size_t tile_count = (rows + rows_per_tile - 1) / rows_per_tile;
+    size_t mask = threshold_map.mask();
+
+    withPixelReader(layout, source_colors, [&](auto read) {
+        pool_ptr->parallelFor(tile_count, [&](size_t tile) {
+            if(isCancelled(cancel)) { return; }
+
+            size_t begin = tile * rows_per_tile;
+            size_t end = std::min(rows, begin + rows_per_tile);
+
+            for(size_t y = begin; y < end; y++)
+            {
+                const uint8_t* source_row = source + (y * source_pitch);
+                uint8_t* dest_row = dest + (y * dest_pitch);
+                // Keyed by image row, so the pattern is the same whichever
+                // way the rows are stored
+                size_t image_row = bottom_up ? first_row - y : first_row + y;
+                const int16_t* offsets = threshold_map.row(image_row);
+
+                for(size_t x = 0; x < width; x++)
+                {
+                    SDL_Color color = read(source_row, x);
+                    int offset = offsets[x & mask];
+                    color.r = clampChannel(color.r + offset);
+                    color.g = clampChannel(color.g + offset);
+                    color.b = clampChannel(color.b + offset);
+                    dest_row[x] = palette_lut.lookup(color);
+                }
+            }
+        });
+    });
+}
+
+
+
+/**
+ * @brief Error diffusion over a whole image. Rows run in parallel as a
+ * wavefront, each a few pixels behind the row above.
+ */
+void ConversionContext::ditherErrorDiffusion(
+        const uint8_t* source,
+        size_t source_pitch,
+        PixelLayout layout,
+        const SDL_Color* source_colors,
+        uint8_t* dest,
+        size_t dest_pitch,
+        size_t width,
+        size_t rows,
+        const CancelToken* cancel
+) const
+{
+    withPixelReader(layout, source_colors, [&](auto read) {
+        if(settings.dither == DitherMode::Atkinson)
+        {
+            diffuseErrors<AtkinsonKernel>(
+                    palette_lut, palette_entries.colors.data(), *pool_ptr, read,
+                    source, source_pitch, dest, dest_pitch, width, rows, cancel
+            );
+        } else
+        {
+            diffuseErrors<FloydSteinbergKernel>(
+                    palette_lut, palette_entries.colors.data(), *pool_ptr, read,
+                    source, source_pitch, dest, dest_pitch, width, rows, cancel
+            );
+        }
+    });
+}
+
+
+
+/**
+ * @brief Exact nearest palette entry by the context's metric, without
+ * the lookup table
+ */
+uint8_t ConversionContext::findClosestPaletteEntry(SDL_Color color) const
+{
+    if(compiled_nearest != nullptr) { return compiled_nearest(color); }
+
+    if(settings.metric == ColorMetric::OKLab)
+    {
+        OKLabColor lab = toOKLab(color);
+
+        uint8_t closestIndex = 0;
+        float lowestDistance = INFINITY;
+        for(size_t i = 0; i < palette_entries.count; i++)
+        {
+            float distance = oklabDistance(palette_lab[i], lab);
+            if(distance < lowestDistance)
+            {
+                lowestDistance = distance;
+                closestIndex = i;
+            }
+        }
+
+        return closestIndex;
+    }
+
+    int index = (nearest_kernel != nullptr) ? nearest_kernel(palette_soa, color) : -1;
+    if(index >= 0) { return static_cast<uint8_t>(index); }
+
+    // Two entries are equally close in fixed point. Let the exact search decide.
+    if(palette_tree.isBuilt()) { return palette_tree.nearest(color); }
+
+    uint8_t closestIndex = 0;
+    double lowestDistance = INFINITY;
+
+    for(size_t i = 0; i < palette_entries.count; i++)
+    {
+        double distance = paletteDistance(palette_entries.colors[i], color);
+
+        if(distance < lowestDistance)
+        {
+            lowestDistance = distance;
+            closestIndex = i;
+        }
+    }
+
+    return closestIndex;
+}
+
+
+
+/**
+ * @brief Converts a bitmap to an indexed 8-bit bitmap, without a window.
+ * Uncompressed 24-bit and 32-bit bitmaps are streamed a band of rows at a
+ * time, so memory use does not grow with the image. Error diffusion loads
+ * the whole image first.
+ * @param input Path to a bitmap
+ * @param output Path to write the indexed bitmap to
+ * @param dark_level 0 to MAX_DARK_LEVEL
+ * @param underwater Apply underwater lighting
+ * @param stats Filled in on success, if not null
+ * @return 0 on success, 1 on failure
+ */
+int ConversionContext::convertBMPFile(
+        const std::string& input,
+        const std::string& output,
+        int dark_level,
+        bool underwater,
+        ConversionStats* stats
+) const
+{
+    BMPHeader header;
+    if(readBMPHeader(input, header) == 0 && isStreamableBMP(header) && canConvertInBands())
+    {
+        return streamConvertBMP(*this, input, output, dark_level, underwater, stats);
+    }
+
+    // Compressed and unusual bitmaps go through SDL
+    int err;
+    SDL_Surface* source = SDL_LoadBMP(input.c_str());
+    if(source == nullptr) { return 1; }
+
+    SDL_Surface* indexed = SDL_CreateRGBSurfaceWithFormat(
+            0,
+            source->w, source->h,
+            8, SDL_PIXELFORMAT_INDEX8
+    );
+    if(indexed == nullptr)
+    {
+        SDL_FreeSurface(source);
+        return 1;
+    }
+
+    // Index8 surfaces get their own palette, so fill that in
+    err = SDL_SetPaletteColors(indexed->format->palette, palette_entries.colors.data(), 0, 256);
+    if(err == 0) { err = convertSurfaceToIndex(source, indexed, stats); }
+    SDL_FreeSurface(source);
+
+    if(err == 0)
+    {
+        uint8_t* pixels = static_cast<uint8_t*>(indexed->pixels);
+        size_t surface_size = static_cast<size_t>(indexed->pitch) * indexed->h;
+        applyLighting(pixels, pixels, surface_size, dark_level, underwater);
+
+        err = SDL_SaveBMP(indexed, output.c_str());
+    }
+
+    SDL_FreeSurface(indexed);
+
+    return err != 0 ? 1 : 0;
+}
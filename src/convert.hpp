@@ -0,0 +1,282 @@
+/******************************************************************************
+ * @file    src/convert.hpp
+ * @project ColorTestSDL2
+ * @brief   Converts true color surfaces to the indexed palette
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_CONVERT_HPP
+#define COLORTESTSDL2_CONVERT_HPP
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include "color_metric.hpp"
+#include "dither.hpp"
+#include "palette.hpp"
+#include "palette_lut.hpp"
+#include "palette_simd.hpp"
+#include "palette_tree.hpp"
+#include "pixel_format.hpp"
+#include "quantizer.hpp"
+#include "thread_pool.hpp"
+
+// Source bytes per conversion tile. Roughly half of a typical L2 cache.
+constexpr size_t CONVERSION_TILE_BYTES = 256 * 1024;
+
+// Pixels an error diffusion row finishes between telling the row below.
+// Smaller lets rows start sooner, larger means less waiting on each other.
+constexpr size_t DIFFUSION_BLOCK = 64;
+
+/**
+ * @brief Settings for a ConversionContext
+ */
+struct ConversionOptions
+{
+    // Threads for a pool the context creates itself. 0 = one per hardware thread.
+    unsigned threads = 0;
+
+    // Quantize each distinct color once instead of once per pixel.
+    // Faster on flat art, slower on photos and noise.
+    bool dedup_colors = false;
+
+    // What the closest palette entry means. OKLab looks better on dark
+    // blues and skin tones, and costs little once the tables are built.
+    ColorMetric metric = ColorMetric::WeightedRGB;
+
+    // Spreads colors between palette entries over nearby pixels, so
+    // gradients do not band. Turns off dedup_colors.
+    DitherMode dither = DitherMode::None;
+};
+
+/**
+ * @brief What a conversion did, for callers that want to report it
+ */
+struct ConversionStats
+{
+    size_t pixels = 0;
+    size_t unique_colors = 0; // Only counted when deduplicating true color sources
+};
+
+/**
+ * @brief Everything a conversion needs: the lookup tables, the settings, and
+ * a pool to run on. Contexts share no state, and a ready context can be used
+ * from several threads at once, so tools can run conversions side by side
+ * without a window.
+ */
+class ConversionContext
+{
+public:
+    /**
+     * @param shared_pool Pool to run on instead of creating one. Must outlive
+     * the context.
+     */
+    explicit ConversionContext(const ConversionOptions& options = ConversionOptions(), ThreadPool* shared_pool = nullptr);
+
+    ConversionContext(const ConversionContext&) = delete;
+    ConversionContext& operator=(const ConversionContext&) = delete;
+
+    /**
+     * @brief Creates the pool and builds the lookup tables
+     * @note Call before converting from several threads at a time.
+     * @return 0 on success, 1 on failure
+     */
+    int init();
+
+    bool isReady() const { return pool_ptr != nullptr && palette_lut.isBuilt(); }
+
+    /**
+     * @brief Pool the context runs on. Only valid after init().
+     */
+    ThreadPool& pool() const { return *pool_ptr; }
+
+    const ConversionOptions& options() const { return settings; }
+
+    /**
+     * @brief Switches to another palette. Before init() this only stores it.
+     * After, only the lookup table cells that changed entries matter in are
+     * rebuilt, so tweaking a few entries takes milliseconds.
+     * @note Not safe while a conversion is running on this context.
+     * @param rebuilt_cells Lookup table cells redone, if not null
+     * @return 0 on success, 1 on failure
+     */
+    int setPalette(const ColorPalette& colors, size_t* rebuilt_cells = nullptr);
+
+    /**
+     * @brief Palette conversions map to. Entries past its count are black.
+     */
+    const ColorPalette& currentPalette() const { return palette_entries; }
+
+    /**
+     * @brief Whether rows can be converted a band at a time. Error diffusion
+     * carries error down the whole image, so it needs every row at once.
+     */
+    bool canConvertInBands() const { return !isErrorDiffusion(settings.dither); }
+
+    /**
+     * @brief Changes deduplication for later conversions.
+     * @note Not safe while a conversion is running on this context.
+     */
+    void setDedupColors(bool enabled) { settings.dedup_colors = enabled; }
+
+    /**
+     * @param stats Filled in on success, if not null
+     * @param cancel Stops the conversion between tiles once set. Fails if it did.
+     * @return 0 on success, 1 on failure
+     */
+    int convertSurfaceToIndex(
+            SDL_Surface* source,
+            SDL_Surface* dest,
+            ConversionStats* stats = nullptr,
+            const CancelToken* cancel = nullptr
+    ) const;
+
+    /**
+     * @brief Converts rows of pixels, splitting them across the pool. Each
+     * source format gets its own copy of the loop. Only valid after init().
+     * @param source First source row
+     * @param source_pitch Bytes between source rows
+     * @param layout Source pixel format
+     * @param dest First Index8 row
+     * @param dest_pitch Bytes between dest rows
+     * @param source_colors 256 entry source palette. Only used by Index8.
+     * @param cancel Skips the remaining tiles once set. The caller checks it
+     * afterwards, since dest is left partly written.
+     * @param first_row Row of the image that source starts at, so ordered
+     * dither patterns line up across bands
+     * @param bottom_up Source rows go up the image, as in most bitmap files.
+     * first_row is then the image row of the first source row, and each
+     * later source row is the one above it.
+     */
+    void convertRows(
+            const uint8_t* source,
+            size_t source_pitch,
+            PixelLayout layout,
+            uint8_t* dest,
+            size_t dest_pitch,
+            size_t width,
+            size_t rows,
+            const SDL_Color* source_colors = nullptr,
+            const CancelToken* cancel = nullptr,
+            size_t first_row = 0,
+            bool bottom_up = false
+    ) const;
+
+    /**
+     * @brief Exact nearest palette entry by the context's metric, without
+     * the lookup table
+     */
+    uint8_t findClosestPaletteEntry(SDL_Color color) const;
+
+    /**
+     * @brief Converts a bitmap to an indexed 8-bit bitmap, without a window.
+     * Uncompressed 24-bit and 32-bit bitmaps are streamed a band of rows at a
+     * time, so memory use does not grow with the image. Error diffusion loads
+     * the whole image first.
+     * @param input Path to a bitmap
+     * @param output Path to write the indexed bitmap to
+     * @param dark_level 0 to MAX_DARK_LEVEL
+     * @param underwater Apply underwater lighting
+     * @param stats Filled in on success, if not null
+     * @return 0 on success, 1 on failure
+     */
+    int convertBMPFile(
+            const std::string& input,
+            const std::string& output,
+            int dark_level,
+            bool underwater,
+            ConversionStats* stats = nullptr
+    ) const;
+
+private:
+    /**
+     * @brief Rebuilds every search structure besides the lookup table for
+     * the current palette. All of them are small next to the table.
+     * @return 0 on success, 1 on failure
+     */
+    int buildPaletteSearch();
+
+    /**
+     * @brief Quantizes each distinct color once, then remaps pixels through the results.
+     * @param source First source row
+     * @param source_pitch Bytes between source rows
+     * @param layout Source pixel format
+     * @param source_colors 256 entry source palette. Only used by Index8.
+     * @param dest First Index8 row
+     * @param dest_pitch Bytes between dest rows
+     * @param cancel Skips the remaining work once set
+     * @return Number of distinct colors
+     */
+    size_t quantizeUniqueColors(
+            const uint8_t* source,
+            size_t source_pitch,
+            PixelLayout layout,
+            const SDL_Color* source_colors,
+            uint8_t* dest,
+            size_t dest_pitch,
+            size_t width,
+            size_t rows,
+            const CancelToken* cancel
+    ) const;
+
+    /**
+     * @brief Ordered dithering. Tiles run in any order, like convertRows.
+     * @param first_row Row of the image that source starts at
+     * @param bottom_up Each source row is the image row above the last
+     */
+    void ditherOrdered(
+            const uint8_t* source,
+            size_t source_pitch,
+            PixelLayout layout,
+            const SDL_Color* source_colors,
+            uint8_t* dest,
+            size_t dest_pitch,
+            size_t width,
+            size_t rows,
+            size_t first_row,
+            bool bottom_up,
+            const CancelToken* cancel
+    ) const;
+
+    /**
+     * @brief Error diffusion over a whole image. Rows run in parallel as a
+     * wavefront, each a few pixels behind the row above.
+     */
+    void ditherErrorDiffusion(
+            const uint8_t* source,
+            size_t source_pitch,
+            PixelLayout layout,
+            const SDL_Color* source_colors,
+            uint8_t* dest,
+            size_t dest_pitch,
+            size_t width,
+            size_t rows,
+            const CancelToken* cancel
+    ) const;
+
+    ConversionOptions settings;
+    ColorPalette palette_entries = builtInPalette();
+
+    ThreadPool* pool_ptr = nullptr;
+    std::unique_ptr<ThreadPool> owned_pool;
+
+    PaletteLUT palette_lut;
+    PaletteSoA palette_soa;
+    NearestKernel nearest_kernel = nullptr;
+    PaletteTree palette_tree;
+    std::array<OKLabColor, 256> palette_lab{};
+
+    // Compiled-in kernel for this metric and palette, if there is one and
+    // nothing faster
+    QuantizeFunction compiled_nearest = nullptr;
+
+    ThresholdMap threshold_map;
+};
+
+#endif //COLORTESTSDL2_CONVERT_HPP
@@ -0,0 +1,275 @@
+/******************************************************************************
+ * @file    src/dither.cpp
+ * @project ColorTestSDL2
+ * @brief   Ordered and error diffusion dithering modes
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "dither.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+
+constexpr size_t BAYER_BITS = 3;
+constexpr size_t BAYER_SIZE = 1 << BAYER_BITS;
+constexpr size_t BLUE_NOISE_SIZE = 32;
+
+/**
+ * @brief The classic recursive Bayer matrix. The lowest bits of x and y pick
+ * the most significant quadrant, so neighbouring thresholds are far apart.
+ */
+constexpr std::array<uint16_t, BAYER_SIZE * BAYER_SIZE> buildBayerMatrix()
+{
+    std::array<uint16_t, BAYER_SIZE * BAYER_SIZE> matrix{};
+
+    for(size_t y = 0; y < BAYER_SIZE; y++)
+    {
+        for(size_t x = 0; x < BAYER_SIZE; x++)
+        {
+            uint16_t value = 0;
+            for(size_t bit = 0; bit < BAYER_BITS; bit++)
+            {
+                size_t x_bit = (x >> bit) & 1;
+                size_t y_bit = (y >> bit) & 1;
+                value = static_cast<uint16_t>((value << 2) | (((x_bit ^ y_bit) << 1) | y_bit));
+            }
+            matrix[(y * BAYER_SIZE) + x] = value;
+        }
+    }
+
+    return matrix;
+}
+
+constexpr std::array<uint16_t, BAYER_SIZE * BAYER_SIZE> bayer_matrix = buildBayerMatrix();
+
+/**
+ * @brief Ranks for a tileable blue noise matrix, by Ulichney's void and
+ * cluster method. Each step fills the emptiest spot left, so every prefix
+ * of the ranks is spread evenly. Built on first use.
+ */
+const std::vector<uint16_t>& blueNoiseMatrix()
+{
+    static const std::vector<uint16_t> matrix = [] {
+        constexpr size_t size = BLUE_NOISE_SIZE;
+        constexpr size_t cells = size * size;
+        constexpr float sigma = 1.5f;
+
+        // Gaussian falloff by wrapped offset, so the matrix tiles
+        std::vector<float> falloff(cells);
+        for(size_t y = 0; y < size; y++)
+        {
+            for(size_t x = 0; x < size; x++)
+            {
+                float dx = static_cast<float>(std::min(x, size - x));
+                float dy = static_cast<float>(std::min(y, size - y));
+                falloff[(y * size) + x] = std::exp(-((dx * dx) + (dy * dy)) / (2 * sigma * sigma));
+            }
+        }
+
+        std::vector<bool> filled(cells, false);
+        std::vector<float> energy(cells, 0.0f);
+        auto toggle = [&](size_t cell, bool on) {
+            filled[cell] = on;
+            float sign = on ? 1.0f : -1.0f;
+            size_t cell_x = cell % size;
+            size_t cell_y = cell / size;
+            for(size_t y = 0; y < size; y++)
+            {
+                size_t dy = (y + size - cell_y) % size;
+                for(size_t x = 0; x < size; x++)
+                {
+                    size_t dx = (x + size - cell_x) % size;
+                    energy[(y * size) + x] += sign * falloff[(dy * size) + dx];
+                }
+            }
+        };
+
+        // Tightest cluster among filled cells, or largest void among empty ones
+        auto extreme = [&](bool want_filled) {
+            size_t best = cells;
+            for(size_t cell = 0; cell < cells; cell++)
+            {
+                if(filled[cell] != want_filled) { continue; }
+                if(best == cells
+                   || (want_filled ? energy[cell] > energy[best] : energy[cell] < energy[best]))
+                {
+                    best = cell;
+                }
+            }
+            return best;
+        };
+
+        // A fixed seed, so every build gets the same matrix. mt19937's raw
+        // output is the same on every standard library.
+        std::mt19937 random(0x5EED);
+        size_t initial = cells / 10;
+        for(size_t placed = 0; placed < initial;)
+        {
+            size_t cell = random() % cells;
+            if(filled[cell]) { continue; }
+            toggle(cell, true);
+            placed++;
+        }
+
+        // Move points from clusters into voids until they settle
+        for(size_t step = 0; step < cells; step++)
+        {
+            size_t cluster = extreme(true);
+            toggle(cluster, false);
+            size_t hole = extreme(false);
+            toggle(hole, true);
+            if(hole == cluster) { break; }
+        }
+
+        std::vector<uint16_t> ranks(cells, 0);
+        std::vector<bool> initial_pattern = filled;
+        std::vector<float> initial_energy = energy;
+
+        // Rank the initial points from the most clustered down
+        for(size_t rank = initial; rank > 0; rank--)
+        {
+            size_t cluster = extreme(true);
+            toggle(cluster, false);
+            ranks[cluster] = static_cast<uint16_t>(rank - 1);
+        }
+
+        // Then fill the voids from the initial points up
+        filled = initial_pattern;
+        energy = initial_energy;
+        for(size_t rank = initial; rank < cells; rank++)
+        {
+            size_t hole = extreme(false);
+            toggle(hole, true);
+            ranks[hole] = static_cast<uint16_t>(rank);
+        }
+
+        return ranks;
+    }();
+
+    return matrix;
+}
+
+}
+
+/**
+ * @brief Fills in the offsets for an ordered mode
+ * @param mode Bayer or BlueNoise
+ * @param spread Distance between the lowest and highest offset
+ * @return 0 on success, 1 if the mode is not an ordered one
+ */
+int ThresholdMap::build(DitherMode mode, float spread)
+{
+    const uint16_t* ranks;
+    size_t size;
+    switch(mode)
+    {
+    case DitherMode::Bayer:
+        ranks = bayer_matrix.data();
+        size = BAYER_SIZE;
+        break;
+    case DitherMode::BlueNoise:
+        ranks = blueNoiseMatrix().data();
+        size = BLUE_NOISE_SIZE;
+        break;
+    default:
+        SDL_SetError("%s is not an ordered dither mode.", ditherModeName(mode));
+        return 1;
+    }
+
+    // Centered on zero, so flat areas on a palette entry stay on it
+    size_t cells = size * size;
+    offsets.resize(cells);
+    for(size_t i = 0; i < cells; i++)
+    {
+        float threshold = ((static_cast<float>(ranks[i]) + 0.5f) / static_cast<float>(cells)) - 0.5f;
+        offsets[i] = static_cast<int16_t>(std::lround(threshold * spread));
+    }
+    mask_bits = size - 1;
+
+    return 0;
+}
+
+
+
+/**
+ * @brief Spread for ordered dithering: twice the median distance from each
+ * palette entry to its closest other one. Pixels move up to half of it either
+ * way, so a color between two typical neighbours can reach both of them.
+ */
+float paletteSpread(const SDL_Color* colors, size_t count)
+{
+    std::vector<float> closest;
+    closest.reserve(count);
+
+    for(size_t i = 0; i < count; i++)
+    {
+        int lowest = INT32_MAX;
+        for(size_t j = 0; j < count; j++)
+        {
+            int dr = colors[i].r - colors[j].r;
+            int dg = colors[i].g - colors[j].g;
+            int db = colors[i].b - colors[j].b;
+            int distance = (dr * dr) + (dg * dg) + (db * db);
+
+            // Repeated entries are one color, not a gap of zero
+            if(distance != 0) { lowest = std::min(lowest, distance); }
+        }
+
+        if(lowest != INT32_MAX) { closest.push_back(std::sqrt(static_cast<float>(lowest))); }
+    }
+
+    if(closest.empty()) { return 0.0f; }
+
+    auto middle = closest.begin() + (closest.size() / 2);
+    std::nth_element(closest.begin(), middle, closest.end());
+    return 2.0f * *middle;
+}
+
+
+
+/**
+ * @brief Name used on the command line and in logs
+ */
+const char* ditherModeName(DitherMode mode)
+{
+    switch(mode)
+    {
+    case DitherMode::None: return "none";
+    case DitherMode::Bayer: return "bayer";
+    case DitherMode::BlueNoise: return "blue-noise";
+    case DitherMode::FloydSteinberg: return "floyd-steinberg";
+    case DitherMode::Atkinson: return "atkinson";
+    }
+
+    return "unknown";
+}
+
+
+
+/**
+ * @brief Parses a ditherModeName()
+ * @return 0 on success, 1 if the name is unknown
+ */
+int parseDitherMode(const std::string& name, DitherMode& mode)
+{
+    for(DitherMode candidate : {
+            DitherMode::None, DitherMode::Bayer, DitherMode::BlueNoise,
+            DitherMode::FloydSteinberg, DitherMode::Atkinson
+    })
+    {
+        if(name == ditherModeName(candidate))
+        {
+            mode = candidate;
+            return 0;
+        }
+    }
+
+    SDL_SetError("Unknown dither mode: %s", name.c_str());
+    return 1;
+}
@@ -0,0 +1,127 @@
+/******************************************************************************
+ * @file    src/dither.hpp
+ * @project ColorTestSDL2
+ * @brief   Ordered and error diffusion dithering modes
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_DITHER_HPP
+#define COLORTESTSDL2_DITHER_HPP
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief How pixels between palette entries are spread over nearby ones
+ */
+enum class DitherMode
+{
+    None,           // Nearest entry only. Fastest, but bands on gradients.
+    Bayer,          // 8x8 ordered pattern. Every pixel is independent.
+    BlueNoise,      // 32x32 ordered pattern without Bayer's cross-hatching
+    FloydSteinberg, // Error diffusion. Smoothest, but rows depend on each other.
+    Atkinson        // Error diffusion that drops a quarter of the error, for more contrast
+};
+
+/**
+ * @brief Whether each pixel depends on the ones before it. These cannot be
+ * converted a band at a time.
+ */
+constexpr bool isErrorDiffusion(DitherMode mode)
+{
+    return mode == DitherMode::FloydSteinberg || mode == DitherMode::Atkinson;
+}
+
+/**
+ * @brief Where a pixel's quantization error goes, in 1 / (1 << SHIFT) parts
+ */
+struct DiffusionTap
+{
+    int dx;
+    int dy;
+    int weight;
+};
+
+/**
+ * @brief A kernel's taps, and how far they reach: rows below, and pixels
+ * left and right
+ */
+struct FloydSteinbergKernel
+{
+    static constexpr int SHIFT = 4;
+    static constexpr size_t ROWS = 1;
+    static constexpr size_t LEFT = 1;
+    static constexpr size_t RIGHT = 1;
+    static constexpr std::array<DiffusionTap, 4> taps = {{
+            { 1, 0, 7 },
+            { -1, 1, 3 }, { 0, 1, 5 }, { 1, 1, 1 }
+    }};
+};
+
+struct AtkinsonKernel
+{
+    static constexpr int SHIFT = 3;
+    static constexpr size_t ROWS = 2;
+    static constexpr size_t LEFT = 1;
+    static constexpr size_t RIGHT = 2;
+    static constexpr std::array<DiffusionTap, 6> taps = {{
+            { 1, 0, 1 }, { 2, 0, 1 },
+            { -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 },
+            { 0, 2, 1 }
+    }};
+};
+
+/**
+ * @brief Per-pixel offsets for ordered dithering, tiled over the image
+ */
+class ThresholdMap
+{
+public:
+    /**
+     * @brief Fills in the offsets for an ordered mode
+     * @param mode Bayer or BlueNoise
+     * @param spread Distance between the lowest and highest offset
+     * @return 0 on success, 1 if the mode is not an ordered one
+     */
+    int build(DitherMode mode, float spread);
+
+    bool isBuilt() const { return !offsets.empty(); }
+
+    /**
+     * @brief Offsets for a row, indexed by x & mask()
+     */
+    const int16_t* row(size_t y) const { return offsets.data() + ((y & mask_bits) * (mask_bits + 1)); }
+
+    size_t mask() const { return mask_bits; }
+
+private:
+    std::vector<int16_t> offsets;
+    size_t mask_bits = 0;
+};
+
+/**
+ * @brief Spread for ordered dithering: twice the median distance from each
+ * palette entry to its closest other one. Pixels move up to half of it either
+ * way, so a color between two typical neighbours can reach both of them.
+ */
+float paletteSpread(const SDL_Color* colors, size_t count);
+
+/**
+ * @brief Name used on the command line and in logs
+ */
+const char* ditherModeName(DitherMode mode);
+
+/**
+ * @brief Parses a ditherModeName()
+ * @return 0 on success, 1 if the name is unknown
+ */
+int parseDitherMode(const std::string& name, DitherMode& mode);
+
+#endif //COLORTESTSDL2_DITHER_HPP
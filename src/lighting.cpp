@@ -0,0 +1,36 @@
+/******************************************************************************
+ * @file    src/lighting.cpp
+ * @project ColorTestSDL2
+ * @brief   Dark level and underwater lighting as palette index remaps
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "lighting.hpp"
+#include "lighting_simd.hpp"
+
+/**
+ * @brief Maps every index through a table. Source and dest may be the same.
+ */
+void remapIndices(const uint8_t* source, uint8_t* dest, size_t count, const IndexRemap& remap)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        dest[i] = remap[source[i]];
+    }
+}
+
+
+
+/**
+ * @brief Applies a dark level and underwater state to every index, with the
+ * fastest kernel the CPU supports. Source and dest may be the same.
+ * @param dark_level 0 to MAX_DARK_LEVEL
+ */
+void applyLighting(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater)
+{
+    static const LightingKernel kernel = selectLightingKernel();
+    kernel(source, dest, count, dark_level, underwater);
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * @file    src/lighting.hpp
+ * @project ColorTestSDL2
+ * @brief   Dark level and underwater lighting as palette index remaps
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_LIGHTING_HPP
+#define COLORTESTSDL2_LIGHTING_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+constexpr int MAX_DARK_LEVEL = 8;
+constexpr int LIGHTING_STATES = (MAX_DARK_LEVEL + 1) * 2;
+
+// Maps every palette index to another
+using IndexRemap = std::array<uint8_t, 256>;
+using LightingTable = IndexRemap;
+
+/**
+ * @brief Lights a single palette index. Each dark level moves two palette
+ * rows down, and underwater moves to the matching odd row.
+ */
+constexpr uint8_t lightIndex(uint8_t color, int dark_level, bool underwater)
+{
+    if((dark_level == MAX_DARK_LEVEL) || (color > UINT8_MAX - (32 * dark_level)))
+    {
+        color = 255;
+    } else
+    {
+        color += (32 * dark_level);
+    }
+
+    if(underwater)
+    {
+        color |= 0x10;
+    }
+
+    return color;
+}
+
+constexpr std::array<LightingTable, LIGHTING_STATES> buildLightingTables()
+{
+    std::array<LightingTable, LIGHTING_STATES> tables{};
+
+    for(int state = 0; state < LIGHTING_STATES; state++)
+    {
+        for(int color = 0; color < 256; color++)
+        {
+            tables[state][color] = lightIndex(
+                    static_cast<uint8_t>(color),
+                    state / 2,
+                    (state % 2) != 0
+            );
+        }
+    }
+
+    return tables;
+}
+
+inline constexpr std::array<LightingTable, LIGHTING_STATES> lighting_tables = buildLightingTables();
+
+/**
+ * @brief Remap table for a lighting state
+ * @param dark_level 0 to MAX_DARK_LEVEL
+ */
+constexpr const LightingTable& lightingTable(int dark_level, bool underwater)
+{
+    return lighting_tables[(dark_level * 2) + (underwater ? 1 : 0)];
+}
+
+/**
+ * @brief Maps every index through a table. Source and dest may be the same.
+ */
+void remapIndices(const uint8_t* source, uint8_t* dest, size_t count, const IndexRemap& remap);
+
+/**
+ * @brief Applies a dark level and underwater state to every index, with the
+ * fastest kernel the CPU supports. Source and dest may be the same.
+ * @param dark_level 0 to MAX_DARK_LEVEL
+ */
+void applyLighting(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater);
+
+#endif //COLORTESTSDL2_LIGHTING_HPP
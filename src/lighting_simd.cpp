@@ -0,0 +1,190 @@
+/******************************************************************************
+ * @file    src/lighting_simd.cpp
+ * @project ColorTestSDL2
+ * @brief   Vectorized dark level and underwater lighting
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "lighting_simd.hpp"
+#include <SDL2/SDL.h>
+#include <cstring>
+#include "lighting.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLORTEST_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define COLORTEST_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC allows intrinsics anywhere, GCC and Clang need them enabled per function.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+
+/**
+ * @brief Handles the darkest level, where every index becomes 255. 32 * 8
+ * does not fit in a byte, so the vector add cannot express it.
+ * @return true if the pixels were written
+ */
+bool fillDarkest(uint8_t* dest, size_t count, int dark_level)
+{
+    if(dark_level < MAX_DARK_LEVEL) { return false; }
+
+    std::memset(dest, 0xFF, count);
+    return true;
+}
+
+#ifdef COLORTEST_X86
+
+TARGET_SSE2
+void lightIndicesSSE2(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater)
+{
+    if(fillDarkest(dest, count, dark_level)) { return; }
+
+    const __m128i add = _mm_set1_epi8(static_cast<char>(32 * dark_level));
+    const __m128i tint = _mm_set1_epi8(underwater ? 0x10 : 0);
+
+    size_t i = 0;
+    for(; i + 64 <= count; i += 64)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 48));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_or_si128(_mm_adds_epu8(a, add), tint));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 16), _mm_or_si128(_mm_adds_epu8(b, add), tint));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 32), _mm_or_si128(_mm_adds_epu8(c, add), tint));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 48), _mm_or_si128(_mm_adds_epu8(d, add), tint));
+    }
+
+    for(; i + 16 <= count; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_or_si128(_mm_adds_epu8(a, add), tint));
+    }
+
+    lightIndicesScalar(source + i, dest + i, count - i, dark_level, underwater);
+}
+
+
+
+TARGET_AVX2
+void lightIndicesAVX2(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater)
+{
+    if(fillDarkest(dest, count, dark_level)) { return; }
+
+    const __m256i add = _mm256_set1_epi8(static_cast<char>(32 * dark_level));
+    const __m256i tint = _mm256_set1_epi8(underwater ? 0x10 : 0);
+
+    size_t i = 0;
+    for(; i + 128 <= count; i += 128)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 32));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 64));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 96));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_or_si256(_mm256_adds_epu8(a, add), tint));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i + 32), _mm256_or_si256(_mm256_adds_epu8(b, add), tint));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i + 64), _mm256_or_si256(_mm256_adds_epu8(c, add), tint));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i + 96), _mm256_or_si256(_mm256_adds_epu8(d, add), tint));
+    }
+
+    for(; i + 32 <= count; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_or_si256(_mm256_adds_epu8(a, add), tint));
+    }
+
+    lightIndicesScalar(source + i, dest + i, count - i, dark_level, underwater);
+}
+
+#endif
+
+#ifdef COLORTEST_NEON
+
+void lightIndicesNEON(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater)
+{
+    if(fillDarkest(dest, count, dark_level)) { return; }
+
+    const uint8x16_t add = vdupq_n_u8(static_cast<uint8_t>(32 * dark_level));
+    const uint8x16_t tint = vdupq_n_u8(underwater ? 0x10 : 0);
+
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        vst1q_u8(dest + i, vorrq_u8(vqaddq_u8(vld1q_u8(source + i), add), tint));
+    }
+
+    lightIndicesScalar(source + i, dest + i, count - i, dark_level, underwater);
+}
+
+#endif
+
+}
+
+
+
+/**
+ * @brief Portable kernel. Used as the fallback and for the tail of the
+ * vectorized kernels.
+ */
+void lightIndicesScalar(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater)
+{
+    remapIndices(source, dest, count, lightingTable(dark_level, underwater));
+}
+
+
+
+/**
+ * @brief Every kernel the CPU can run, fastest first. Scalar is always last,
+ * so each vectorized kernel can be checked against it.
+ */
+std::vector<LightingKernelInfo> supportedLightingKernels()
+{
+    std::vector<LightingKernelInfo> kernels;
+#if defined(COLORTEST_X86)
+    if(SDL_HasAVX2()) { kernels.push_back({ "AVX2", lightIndicesAVX2 }); }
+    if(SDL_HasSSE2()) { kernels.push_back({ "SSE2", lightIndicesSSE2 }); }
+#elif defined(COLORTEST_NEON)
+    kernels.push_back({ "NEON", lightIndicesNEON });
+#endif
+    kernels.push_back({ "Scalar", lightIndicesScalar });
+
+    return kernels;
+}
+
+
+
+/**
+ * @brief Picks the fastest kernel the CPU supports. Checked once.
+ */
+LightingKernel selectLightingKernel()
+{
+    static const LightingKernel kernel = supportedLightingKernels().front().kernel;
+    return kernel;
+}
+
+
+
+/**
+ * @brief Name of the kernel selectLightingKernel() returns, for logging
+ */
+const char* lightingKernelName()
+{
+    static const char* name = supportedLightingKernels().front().name;
+    return name;
+}
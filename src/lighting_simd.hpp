@@ -0,0 +1,56 @@
+/******************************************************************************
+ * @file    src/lighting_simd.hpp
+ * @project ColorTestSDL2
+ * @brief   Vectorized dark level and underwater lighting
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_LIGHTING_SIMD_HPP
+#define COLORTESTSDL2_LIGHTING_SIMD_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Lights count indices, the same as lightIndex() on each. Lighting is
+ * a saturating add of 32 per dark level, then an OR with 0x10 underwater, so
+ * it vectorizes without a table. Source and dest may be the same.
+ */
+using LightingKernel = void (*)(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater);
+
+/**
+ * @brief Portable kernel. Used as the fallback and for the tail of the
+ * vectorized kernels.
+ */
+void lightIndicesScalar(const uint8_t* source, uint8_t* dest, size_t count, int dark_level, bool underwater);
+
+/**
+ * @brief A kernel and the name it is logged under
+ */
+struct LightingKernelInfo
+{
+    const char* name;
+    LightingKernel kernel;
+};
+
+/**
+ * @brief Every kernel the CPU can run, fastest first. Scalar is always last,
+ * so each vectorized kernel can be checked against it.
+ */
+std::vector<LightingKernelInfo> supportedLightingKernels();
+
+/**
+ * @brief Picks the fastest kernel the CPU supports. Checked once.
+ */
+LightingKernel selectLightingKernel();
+
+/**
+ * @brief Name of the kernel selectLightingKernel() returns, for logging
+ */
+const char* lightingKernelName();
+
+#endif //COLORTESTSDL2_LIGHTING_SIMD_HPP
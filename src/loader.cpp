@@ -0,0 +1,217 @@
+/******************************************************************************
+ * @file    src/loader.cpp
+ * @project ColorTestSDL2
+ * @brief   Loads and converts dropped bitmaps off the main thread
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "loader.hpp"
+#include <iostream>
+#include "bmp_stream.hpp"
+
+ImageLoader::ImageLoader(const ConversionContext& context, Uint32 ready_event)
+    : context(context), ready_event(ready_event)
+{
+}
+
+
+
+ImageLoader::~ImageLoader()
+{
+    stop();
+}
+
+
+
+/**
+ * @return 0 on success, 1 on failure
+ */
+int ImageLoader::start()
+{
+    if(thread.joinable()) { return 0; }
+
+    pending = SDL_CreateSemaphore(0);
+    if(pending == nullptr) { return 1; }
+
+    stopping = false;
+    thread = std::thread(&ImageLoader::run, this);
+
+    return 0;
+}
+
+
+
+/**
+ * @brief Stops the thread, and frees anything it had not handed over
+ */
+void ImageLoader::stop()
+{
+    if(thread.joinable())
+    {
+        stopping = true;
+        superseded = true;
+        SDL_SemPost(pending);
+        thread.join();
+    }
+
+    SDL_DestroySemaphore(pending);
+    pending = nullptr;
+
+    // Nobody else is left to pop, so this thread may take both ends now
+    std::string path;
+    while(requests.tryPop(path)) {}
+
+    LoadedImage image;
+    while(loaded.tryPop(image))
+    {
+        SDL_FreeSurface(image.surface);
+    }
+}
+
+
+
+/**
+ * @brief Queues a bitmap to load, and cancels any load still running,
+ * since only the newest drop is shown. Main thread only.
+ * @return 0 on success, 1 if too many loads are waiting
+ */
+int ImageLoader::request(const std::string& path)
+{
+    std::string queued = path;
+    if(pending == nullptr || !requests.tryPush(std::move(queued)))
+    {
+        SDL_SetError("Too many bitmaps are waiting to load.");
+        return 1;
+    }
+
+    // After the push, so a thread that sees the flag also sees the request
+    superseded = true;
+    SDL_SemPost(pending);
+    return 0;
+}
+
+
+
+/**
+ * @brief Takes the next finished load, if there is one. Main thread only.
+ */
+bool ImageLoader::takeLoaded(LoadedImage& image)
+{
+    return loaded.tryPop(image);
+}
+
+
+
+void ImageLoader::run()
+{
+    // Kept after a cancelled load. The request that cancelled it may be
+    // this very path, popped before its flag was set, and then nothing
+    // newer waits. Its wakeup is still to come, and loads it again.
+    std::string path;
+
+    while(true)
+    {
+        SDL_SemWait(pending);
+        if(stopping) { return; }
+
+        // Clear the flag before looking at the queue. A request that lands
+        // after this sets it again, and cancels the load below.
+        superseded.exchange(false);
+
+        // Only the newest request is worth loading. The semaphore still
+        // counts the skipped ones, so those wakeups find the queue empty.
+        std::string newer;
+        while(requests.tryPop(newer)) { path = std::move(newer); }
+        if(path.empty()) { continue; }
+
+        LoadedImage image;
+        image.path = path;
+        image.surface = loadIndexedSurface(context, path, &superseded);
+        if(image.surface == nullptr)
+        {
+            // Retried on the wakeup of the request that set the flag, unless
+            // a newer one has replaced it by then
+            if(isCancelled(&superseded)) { continue; }
+            image.error = SDL_GetError();
+        }
+        path.clear();
+
+        // The main thread drains this on every wakeup, so it only fills up
+        // if the window stops responding
+        while(!loaded.tryPush(std::move(image)))
+        {
+            if(stopping)
+            {
+                SDL_FreeSurface(image.surface);
+                return;
+            }
+            SDL_Delay(1);
+        }
+
+        SDL_Event event{};
+        event.type = ready_event;
+        SDL_PushEvent(&event);
+    }
+}
+
+
+
+/**
+ * @brief Loads a bitmap and converts it to a new Index8 surface. Plain 24-bit
+ * and 32-bit bitmaps are converted as they are read, unless error diffusion
+ * needs the whole image.
+ * @param cancel Stops the load between tiles once set. Fails if it did.
+ * @return The surface, or nullptr on failure. The caller owns it.
+ */
+SDL_Surface* loadIndexedSurface(const ConversionContext& context, const std::string& path, const CancelToken* cancel)
+{
+    BMPHeader header;
+    if(readBMPHeader(path, header) == 0 && isStreamableBMP(header) && context.canConvertInBands())
+    {
+        return loadIndexedBMP(context, path, cancel);
+    }
+
+    SDL_Surface* source = SDL_LoadBMP(path.c_str());
+    if(source == nullptr) { return nullptr; }
+
+    SDL_Surface* indexed = SDL_CreateRGBSurfaceWithFormat(
+            0,
+            source->w, source->h,
+            8, SDL_PIXELFORMAT_INDEX8
+    );
+    if(indexed == nullptr)
+    {
+        SDL_FreeSurface(source);
+        return nullptr;
+    }
+
+    // The surface carries the palette it was converted to
+    int err = SDL_SetPaletteColors(indexed->format->palette, context.currentPalette().colors.data(), 0, 256);
+    if(err != 0)
+    {
+        SDL_FreeSurface(source);
+        SDL_FreeSurface(indexed);
+        return nullptr;
+    }
+
+    ConversionStats stats;
+    err = context.convertSurfaceToIndex(source, indexed, &stats, cancel);
+    SDL_FreeSurface(source);
+
+    if(err != 0)
+    {
+        SDL_FreeSurface(indexed);
+        return nullptr;
+    }
+
+    if(stats.unique_colors != 0)
+    {
+        std::cout << "Unique colors: " << stats.unique_colors
+                  << " in " << stats.pixels << " pixels" << std::endl;
+    }
+
+    return indexed;
+}
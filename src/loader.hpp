@@ -0,0 +1,99 @@
+/******************************************************************************
+ * @file    src/loader.hpp
+ * @project ColorTestSDL2
+ * @brief   Loads and converts dropped bitmaps off the main thread
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_LOADER_HPP
+#define COLORTESTSDL2_LOADER_HPP
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "convert.hpp"
+#include "spsc_queue.hpp"
+
+/**
+ * @brief A finished load, handed from the loader to the main thread
+ */
+struct LoadedImage
+{
+    std::string path;
+    SDL_Surface* surface = nullptr; // Index8, owned by whoever takes it
+    std::string error;              // Set if surface is null
+};
+
+/**
+ * @brief Decodes and quantizes bitmaps on its own thread, so the window keeps
+ * drawing while a large file loads. Paths go in and finished surfaces come
+ * out through lock-free queues, and an SDL event wakes the main loop when
+ * one is ready.
+ */
+class ImageLoader
+{
+public:
+    /**
+     * @param ready_event Event type pushed whenever an image is ready
+     */
+    ImageLoader(const ConversionContext& context, Uint32 ready_event);
+    ~ImageLoader();
+
+    ImageLoader(const ImageLoader&) = delete;
+    ImageLoader& operator=(const ImageLoader&) = delete;
+
+    /**
+     * @return 0 on success, 1 on failure
+     */
+    int start();
+
+    /**
+     * @brief Stops the thread, and frees anything it had not handed over
+     */
+    void stop();
+
+    /**
+     * @brief Queues a bitmap to load, and cancels any load still running,
+     * since only the newest drop is shown. Main thread only.
+     * @return 0 on success, 1 if too many loads are waiting
+     */
+    int request(const std::string& path);
+
+    /**
+     * @brief Takes the next finished load, if there is one. Main thread only.
+     */
+    bool takeLoaded(LoadedImage& image);
+
+private:
+    void run();
+
+    const ConversionContext& context;
+    Uint32 ready_event;
+
+    SPSCQueue<std::string, 64> requests;
+    SPSCQueue<LoadedImage, 8> loaded;
+
+    // Counts queued requests, so the thread can sleep while there are none
+    SDL_sem* pending = nullptr;
+    std::atomic<bool> stopping{false};
+
+    // Set by every request, and cleared when the thread picks up work. The
+    // running load checks it per tile, and gives up once a newer one waits.
+    CancelToken superseded{false};
+    std::thread thread;
+};
+
+/**
+ * @brief Loads a bitmap and converts it to a new Index8 surface. Plain 24-bit
+ * and 32-bit bitmaps are converted as they are read, unless error diffusion
+ * needs the whole image.
+ * @param cancel Stops the load between tiles once set. Fails if it did.
+ * @return The surface, or nullptr on failure. The caller owns it.
+ */
+SDL_Surface* loadIndexedSurface(const ConversionContext& context, const std::string& path, const CancelToken* cancel = nullptr);
+
+#endif //COLORTESTSDL2_LOADER_HPP
@@ -8,24 +8,179 @@
 
 
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
 #include <SDL2/SDL.h>
 #include "main.hpp"
+#include "batch.hpp"
+#include "convert.hpp"
+#include "lighting.hpp"
+#include "loader.hpp"
+#include "palette_file.hpp"
 
 SDL_Window* window = nullptr;
 SDL_Renderer* renderer = nullptr;
 SDL_Surface* render_surface = nullptr;
 SDL_Surface* lit_surface = nullptr;
 SDL_Texture* render_texture = nullptr;
-SDL_Palette* indexed_palette = new SDL_Palette{ 256, const_cast<SDL_Color*>(palette.data()) };
+SDL_Palette* indexed_palette = nullptr;
+SDL_Palette* lit_palette = nullptr;
+
+ConversionOptions conversion_options;
+std::unique_ptr<ConversionContext> conversion_context;
+
+// Dropped files are decoded and converted here, off the main thread
+std::unique_ptr<ImageLoader> image_loader;
+Uint32 loader_event = static_cast<Uint32>(-1);
+
+// Newest bitmap asked for, so a new palette can convert it again
+std::string requested_image_path;
+
+// Longest the main loop sleeps while waiting for events
+constexpr int IDLE_TIMEOUT_MS = 250;
 
 bool exitRequested = false;
+bool needsRedraw = true;
 int darkLevel = 0;
 bool underWater = false;
+bool paletteLighting = false;
+
+// Every lighting state of the current image, rendered in the background so
+// toggling is a texture swap. Images needing more than the cap are lit on
+// demand instead.
+bool precomputeLighting = false;
+size_t precomputeCapBytes = size_t(768) * 1024 * 1024;
+std::array<SDL_Texture*, LIGHTING_STATES> lit_textures{};
+std::array<std::vector<uint32_t>, LIGHTING_STATES> lit_frames;
+std::array<std::atomic<bool>, LIGHTING_STATES> lit_frame_ready{};
+CancelToken precompute_cancel{false};
+std::thread precompute_thread;
+Uint32 precompute_event = static_cast<Uint32>(-1);
 
 int SDL_main(int argc, char** argv)
 {
     int err;
+    std::string convert_input;
+    std::string convert_output;
+    std::vector<std::string> batch_inputs;
+    std::string palette_path;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--convert" && i + 1 < argc)
+        {
+            convert_input = argv[++i];
+        } else if(arg == "--batch" && i + 1 < argc)
+        {
+            batch_inputs.push_back(argv[++i]);
+        } else if(arg == "-o" && i + 1 < argc)
+        {
+            convert_output = argv[++i];
+        } else if(arg == "--dark" && i + 1 < argc)
+        {
+            darkLevel = std::clamp(std::atoi(argv[++i]), 0, MAX_DARK_LEVEL);
+        } else if(arg == "--underwater")
+        {
+            underWater = true;
+        } else if(arg == "--threads" && i + 1 < argc)
+        {
+            conversion_options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if(arg == "--dedup")
+        {
+            conversion_options.dedup_colors = true;
+        } else if(arg == "--metric" && i + 1 < argc)
+        {
+            err = parseColorMetric(argv[++i], conversion_options.metric);
+            if(err != 0)
+            {
+                std::cerr << SDL_GetError() << std::endl;
+                return 1;
+            }
+        } else if(arg == "--dither" && i + 1 < argc)
+        {
+            err = parseDitherMode(argv[++i], conversion_options.dither);
+            if(err != 0)
+            {
+                std::cerr << SDL_GetError() << std::endl;
+                return 1;
+            }
+        } else if(arg == "--palette" && i + 1 < argc)
+        {
+            palette_path = argv[++i];
+        } else if(arg == "--palette-lighting")
+        {
+            paletteLighting = true;
+        } else if(arg == "--precompute-lighting")
+        {
+            precomputeLighting = true;
+        } else if(arg == "--precompute-cap" && i + 1 < argc)
+        {
+            precomputeCapBytes = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024 * 1024;
+        }
+    }
+
+    conversion_context = std::make_unique<ConversionContext>(conversion_options);
+
+    if(!palette_path.empty())
+    {
+        ColorPalette colors;
+        err = loadPaletteFile(palette_path, colors);
+        if(err == 0) { err = conversion_context->setPalette(colors); }
+        if(err != 0)
+        {
+            std::cerr << "Could not load palette " << palette_path << ": " << SDL_GetError() << std::endl;
+            return 1;
+        }
+    }
+
+    err = conversion_context->init();
+    if(err != 0)
+    {
+        std::cerr << "Could not prepare conversion: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    // Headless modes. No window or renderer.
+    if(!batch_inputs.empty())
+    {
+        if(convert_output.empty())
+        {
+            std::cerr << "Usage: --batch dir|glob [--batch ...] -o outdir [--dark N] [--underwater]" << std::endl;
+            return 1;
+        }
+
+        err = convertBatch(*conversion_context, batch_inputs, convert_output, darkLevel, underWater);
+
+        conversion_context.reset();
+        return err;
+    }
+
+    if(!convert_input.empty())
+    {
+        if(convert_output.empty())
+        {
+            std::cerr << "Usage: --convert in.bmp -o out.bmp [--dark N] [--underwater]" << std::endl;
+            return 1;
+        }
+
+        err = conversion_context->convertBMPFile(convert_input, convert_output, darkLevel, underWater);
+        if(err != 0)
+        {
+            std::cerr << "Could not convert " << convert_input << ": " << SDL_GetError() << std::endl;
+        }
+
+        conversion_context.reset();
+        return err;
+    }
+
     err = initSDL2();
     if(err != 0)
     {
@@ -33,15 +188,24 @@ int SDL_main(int argc, char** argv)
         return 1;
     }
 
-    // Main loop
+    // Main loop. Only draws when something changed.
     while(!exitRequested)
     {
-        SDL_RenderClear(renderer);
-        if(render_texture != nullptr)
+        if(needsRedraw)
         {
-            SDL_RenderCopy(renderer, render_texture, nullptr, nullptr);
+            SDL_RenderClear(renderer);
+
+            // A precomputed variant if there is one, so toggling is a swap
+            SDL_Texture* lit_texture = lit_textures[(darkLevel * 2) + (underWater ? 1 : 0)];
+            SDL_Texture* texture = (lit_texture != nullptr) ? lit_texture : render_texture;
+            if(texture != nullptr)
+            {
+                SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+            }
+            SDL_RenderPresent(renderer);
+
+            needsRedraw = false;
         }
-        SDL_RenderPresent(renderer);
 
         handleEvents();
     }
@@ -81,6 +245,22 @@ int initSDL2()
     );
     if(renderer == nullptr) { return 1; }
 
+    // Surfaces reference count their palette, so it must come from SDL
+    indexed_palette = SDL_AllocPalette(256);
+    if(indexed_palette == nullptr) { return 1; }
+    err = SDL_SetPaletteColors(indexed_palette, conversion_context->currentPalette().colors.data(), 0, 256);
+    if(err != 0) { return 1; }
+
+    lit_palette = SDL_AllocPalette(256);
+    if(lit_palette == nullptr) { return 1; }
+
+    precompute_event = SDL_RegisterEvents(1);
+    loader_event = SDL_RegisterEvents(1);
+
+    image_loader = std::make_unique<ImageLoader>(*conversion_context, loader_event);
+    err = image_loader->start();
+    if(err != 0) { return 1; }
+
     SDL_RenderSetLogicalSize(
         renderer,
         800,
@@ -98,11 +278,17 @@ int initSDL2()
 
 void quitSDL2()
 {
+    stopLightingPrecompute();
+    image_loader.reset();
+
     SDL_DestroyWindow(window);
     SDL_DestroyRenderer(renderer);
     SDL_FreeSurface(render_surface);
+    SDL_FreeSurface(lit_surface);
     SDL_DestroyTexture(render_texture);
     SDL_FreePalette(indexed_palette);
+    SDL_FreePalette(lit_palette);
+    conversion_context.reset();
 
     SDL_Quit();
 }
@@ -114,8 +300,24 @@ void handleEvents()
     SDL_Event event;
     int err;
 
+    // Sleep until an event arrives, unless a frame is waiting to be drawn
+    if(!needsRedraw && SDL_WaitEventTimeout(nullptr, IDLE_TIMEOUT_MS) == 0) { return; }
+
     while(SDL_PollEvent(&event))
     {
+        // Registered at runtime, so it cannot be a case label
+        if(event.type == precompute_event)
+        {
+            uploadPrecomputedLighting();
+            continue;
+        }
+
+        if(event.type == loader_event)
+        {
+            showLoadedImage();
+            continue;
+        }
+
         switch(event.type)
         {
         case SDL_QUIT:
@@ -124,21 +326,25 @@ void handleEvents()
             break;
         }
 
+        case SDL_WINDOWEVENT:
+        {
+            // Exposed, resized, restored, etc. all need the window redrawn
+            needsRedraw = true;
+            break;
+        }
+
         case SDL_DROPFILE:
         {
-            err = loadNewBMP(event.drop.file);
-            if(err != 0)
+            if(isPaletteFile(event.drop.file))
+            {
+                err = loadNewPalette(event.drop.file);
+                if(err != 0) { showLoadError(SDL_GetError(), "palette"); }
+            } else
             {
-                std::string msg = "Could not load bitmap: ";
-                msg += SDL_GetError();
-
-                SDL_ShowSimpleMessageBox(
-                        SDL_MESSAGEBOX_ERROR,
-                        "Error",
-                        msg.c_str(),
-                        window
-                );
+                err = loadNewBMP(event.drop.file);
+                if(err != 0) { showLoadError(SDL_GetError()); }
             }
+            SDL_free(event.drop.file);
             break;
         }
 
@@ -149,24 +355,21 @@ void handleEvents()
             case SDL_SCANCODE_UP:
             {
                 if(darkLevel > 0) { darkLevel--; }
-                updateDarkLevel();
-                updateUnderwater();
+                updateLighting();
                 break;
             }
 
             case SDL_SCANCODE_DOWN:
             {
-                if(darkLevel < 8) { darkLevel++; }
-                updateDarkLevel();
-                updateUnderwater();
+                if(darkLevel < MAX_DARK_LEVEL) { darkLevel++; }
+                updateLighting();
                 break;
             }
 
             case SDL_SCANCODE_SPACE:
             {
                 underWater = !underWater;
-                updateDarkLevel();
-                updateUnderwater();
+                updateLighting();
                 break;
             }
 
@@ -181,42 +384,128 @@ void handleEvents()
 
 
 /**
- * @brief Loads a new bitmap, and renders it as an indexed texture
+ * @brief Queues a new bitmap to load in the background. It replaces the
+ * current image once it has been converted.
  * @param filepath
  * @return 0 on success, 1 on failure
  */
 int loadNewBMP(const std::string& filepath)
 {
-    int err;
-    SDL_Surface* temp = SDL_LoadBMP(filepath.c_str());
-    if(temp == nullptr) { return 1; }
+    int err = image_loader->request(filepath);
+    if(err != 0) { return 1; }
 
-    err = renderNewSurface(temp);
+    requested_image_path = filepath;
+    return 0;
+}
 
-    SDL_FreeSurface(temp);
 
-    return err;
+
+/**
+ * @brief Switches conversion to a palette file, and converts the current
+ * image again with it. Only the parts of the lookup table the changed
+ * entries affect are rebuilt.
+ * @param filepath JASC, GIMP or ACT palette
+ * @return 0 on success, 1 on failure
+ */
+int loadNewPalette(const std::string& filepath)
+{
+    ColorPalette colors;
+    int err = loadPaletteFile(filepath, colors);
+    if(err != 0) { return 1; }
+
+    // The loader reads the tables, so it has to stop while they change
+    image_loader->stop();
+
+    auto start = std::chrono::steady_clock::now();
+    size_t rebuilt_cells = 0;
+    err = conversion_context->setPalette(colors, &rebuilt_cells);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    int start_err = image_loader->start();
+    if(err != 0 || start_err != 0) { return 1; }
+
+    std::cout << "Palette: " << colors.count << " entries, rebuilt " << rebuilt_cells << " of "
+              << PaletteLUT::CELL_COUNT << " lookup cells in " << elapsed.count() << " ms" << std::endl;
+
+    if(requested_image_path.empty()) { return 0; }
+    return image_loader->request(requested_image_path);
 }
 
 
+
 /**
- * @brief Clears the window and renders a new surface onto it.
- * @param surface Pointer to an existing surface. Main does not obtain ownership of it.
+ * @brief Shows the newest image the loader has finished. Older ones still
+ * waiting were superseded by later drops, so they are only freed.
  */
-int renderNewSurface(SDL_Surface* surface)
+void showLoadedImage()
 {
-    int err;
+    LoadedImage image;
+    LoadedImage newest;
+    bool found = false;
 
-    // FIXME: This causes a crash, but not freeing causes memory leak.
-    //SDL_FreeSurface(render_surface);
-    //SDL_DestroyTexture(render_texture);
+    while(image_loader->takeLoaded(image))
+    {
+        if(!image.error.empty())
+        {
+            showLoadError(image.error);
+            continue;
+        }
 
-    render_surface = SDL_CreateRGBSurfaceWithFormat(
-            0,
-            surface->w, surface->h,
-            8, SDL_PIXELFORMAT_INDEX8
+        SDL_FreeSurface(newest.surface);
+        newest = std::move(image);
+        found = true;
+    }
+
+    if(!found) { return; }
+
+    int err = showIndexedSurface(newest.surface);
+    if(err != 0) { showLoadError(SDL_GetError()); }
+}
+
+
+
+/**
+ * @brief Tells the user a file could not be loaded
+ * @param what What the file was, for the message
+ */
+void showLoadError(const std::string& reason, const std::string& what)
+{
+    std::string msg = "Could not load " + what + ": ";
+    msg += reason;
+
+    SDL_ShowSimpleMessageBox(
+            SDL_MESSAGEBOX_ERROR,
+            "Error",
+            msg.c_str(),
+            window
     );
-    if(render_surface == nullptr) { return 1; }
+}
+
+
+
+/**
+ * @brief Replaces render_surface with an already converted surface, and
+ * queues it to be drawn.
+ * @param indexed Index8 surface. Main takes ownership of it.
+ * @return 0 on success, 1 on failure
+ */
+int showIndexedSurface(SDL_Surface* indexed)
+{
+    int err;
+
+    // The worker reads render_surface, so it has to stop first
+    stopLightingPrecompute();
+
+    // The texture is kept, and only recreated if the size changes
+    SDL_FreeSurface(render_surface);
+    SDL_FreeSurface(lit_surface);
+    lit_surface = nullptr;
+    render_surface = indexed;
+
+    // Shown through the palette it was converted with, which changes when
+    // a palette file is dropped
+    err = SDL_SetPaletteColors(indexed_palette, render_surface->format->palette->colors, 0, 256);
+    if(err != 0) { return 1; }
 
     err = SDL_SetSurfacePalette(
             render_surface,
@@ -224,15 +513,9 @@ int renderNewSurface(SDL_Surface* surface)
     );
     if(err != 0) { return 1; }
 
-    err = convertSurfaceToIndex(surface, render_surface);
+    err = updateRenderTexture(render_surface);
     if(err != 0) { return 1; }
 
-    render_texture = SDL_CreateTextureFromSurface(
-            renderer,
-            render_surface
-    );
-    if(render_texture == nullptr) { return 1; }
-
     // Use SDL2 for easy scaling
     err = SDL_RenderSetLogicalSize(
             renderer,
@@ -241,191 +524,299 @@ int renderNewSurface(SDL_Surface* surface)
     );
     if(err != 0) { return 1; }
 
-    SDL_RenderClear(renderer);
-
-    err = SDL_RenderCopy(
-            renderer,
-            render_texture,
-            nullptr, nullptr
-    );
-    if(err != 0) { return 1; }
+    startLightingPrecompute();
 
-    SDL_RenderPresent(renderer);
+    needsRedraw = true;
 
     return 0;
 }
 
 
 
-int convertSurfaceToIndex(SDL_Surface* source, SDL_Surface* dest)
+/**
+ * @brief Copies an indexed surface into render_texture through its palette.
+ * The streaming texture is reused, and only recreated if the size changes.
+ * @param surface Index8 surface with a palette
+ * @return 0 on success, 1 on failure
+ */
+int updateRenderTexture(SDL_Surface* surface)
 {
-    // Lots of error checking
-    if(source == nullptr || dest == nullptr) { return 1; }
-
     int err;
-    size_t source_count = source->w * source->h;
-    size_t dest_count = dest->w * dest->h;
 
-    uint8_t* source_pixels = static_cast<uint8_t*>(source->pixels);
-    uint8_t* dest_pixels = static_cast<uint8_t*>(dest->pixels);
-
-    if(source->format->BitsPerPixel != 24)
+    if(surface->format->BitsPerPixel != 8 || surface->format->palette == nullptr)
     {
-        SDL_SetError("Source Surface is not RGB888.");
+        SDL_SetError("Render Surface is not Index8.");
         return 1;
     }
 
-    if(dest->format->BitsPerPixel != 8)
+    if(render_texture != nullptr)
     {
-        SDL_SetError("Dest Surface is not Index8.");
-        return 1;
-    }
-
-    if(source_count != dest_count)
-    {
-        SDL_SetError("Source Surface and Dest Surface resolutions are not equal.");
-        return 1;
-    }
-
-    err = SDL_LockSurface(source);
-    if(err != 0) {
-        SDL_UnlockSurface(source);
-        return 1;
+        int texture_w, texture_h;
+        err = SDL_QueryTexture(render_texture, nullptr, nullptr, &texture_w, &texture_h);
+        if(err != 0 || texture_w != surface->w || texture_h != surface->h)
+        {
+            SDL_DestroyTexture(render_texture);
+            render_texture = nullptr;
+        }
     }
 
-    err = SDL_LockSurface(dest);
-    if(err != 0)
+    if(render_texture == nullptr)
     {
-        SDL_UnlockSurface(source);
-        SDL_UnlockSurface(dest);
-        return 1;
+        render_texture = SDL_CreateTexture(
+                renderer,
+                SDL_PIXELFORMAT_ARGB8888,
+                SDL_TEXTUREACCESS_STREAMING,
+                surface->w, surface->h
+        );
+        if(render_texture == nullptr) { return 1; }
     }
 
-
-    // Copy pixels
-    for(int i = 0; i < source_count; i++)
+    // Expand the palette once, instead of once per pixel
+    const SDL_Palette* surface_palette = surface->format->palette;
+    std::array<uint32_t, 256> argb{};
+    for(int i = 0; i < surface_palette->ncolors && i < 256; i++)
     {
-        int offset = i * 3;
-        SDL_Color color = {
-                source_pixels[offset + 2],
-                source_pixels[offset + 1],
-                source_pixels[offset]
-        };
-
-        dest_pixels[i] = findClosestPaletteEntry(color);
+        SDL_Color color = surface_palette->colors[i];
+        argb[i] = 0xFF000000u | (uint32_t(color.r) << 16) | (uint32_t(color.g) << 8) | color.b;
     }
 
-    SDL_UnlockSurface(source);
-    SDL_UnlockSurface(dest);
-
-    return 0;
-}
+    void* texture_pixels;
+    int texture_pitch;
+    err = SDL_LockTexture(render_texture, nullptr, &texture_pixels, &texture_pitch);
+    if(err != 0) { return 1; }
 
+    const uint8_t* source_pixels = static_cast<const uint8_t*>(surface->pixels);
+    uint8_t* dest_pixels = static_cast<uint8_t*>(texture_pixels);
 
-uint8_t findClosestPaletteEntry(SDL_Color color)
-{
-    uint8_t closestIndex = 0;
-    double lowestDistance = INFINITY;
+    size_t rows_per_tile = std::max<size_t>(1, CONVERSION_TILE_BYTES / (static_cast<size_t>(surface->w) * 4));
+    size_t tile_count = (static_cast<size_t>(surface->h) + rows_per_tile - 1) / rows_per_tile;
+    conversion_context->pool().parallelFor(tile_count, [&](size_t tile) {
+        size_t begin = tile * rows_per_tile;
+        size_t end = std::min(static_cast<size_t>(surface->h), begin + rows_per_tile);
 
-    for(size_t i = 0; i < palette.size(); i++)
-    {
-        SDL_Color p_color = palette.at(i);
-        // Weighted euclidean algorithm. Green is most sensitive.
-        double distance =
-                (((p_color.r - color.r) * (p_color.r - color.r)) * 0.30)
-                + (((p_color.g - color.g) * (p_color.g - color.g)) * 0.59)
-                + (((p_color.b - color.b) * (p_color.b - color.b)) * 0.11);
-
-        if(distance < lowestDistance)
+        for(size_t y = begin; y < end; y++)
         {
-            lowestDistance = distance;
-            closestIndex = i;
+            const uint8_t* source_row = source_pixels + (y * surface->pitch);
+            uint32_t* dest_row = reinterpret_cast<uint32_t*>(dest_pixels + (y * texture_pitch));
+            for(int x = 0; x < surface->w; x++)
+            {
+                dest_row[x] = argb[source_row[x]];
+            }
         }
-    }
+    });
+
+    SDL_UnlockTexture(render_texture);
 
-    return closestIndex;
+    return 0;
 }
 
 
 
-void updateDarkLevel()
+void updateLighting()
 {
     if(render_surface == nullptr) { return; }
 
+    // Already rendered in the background. The main loop draws it.
+    if(lit_textures[(darkLevel * 2) + (underWater ? 1 : 0)] != nullptr)
+    {
+        needsRedraw = true;
+        return;
+    }
+
+    if(paletteLighting)
+    {
+        updateLightingPalette();
+        return;
+    }
+
     std::string render_format = SDL_GetPixelFormatName(render_surface->format->format);
     std::cout << "Render Format: " << render_format << std::endl;
 
-    size_t surface_size = render_surface->w * render_surface->h;
+    if(lit_surface == nullptr)
+    {
+        lit_surface = SDL_CreateRGBSurfaceWithFormat(
+            0,
+            render_surface->w,
+            render_surface->h,
+            8,
+            SDL_PIXELFORMAT_INDEX8
+        );
+        if(lit_surface == nullptr) { return; }
+        SDL_SetSurfacePalette(lit_surface, indexed_palette);
+    }
 
-    SDL_FreeSurface(lit_surface);
-    lit_surface = SDL_CreateRGBSurfaceWithFormat(
-        0,
-        render_surface->w,
-        render_surface->h,
-        8,
-        SDL_PIXELFORMAT_INDEX8
-    );
-    SDL_SetSurfacePalette(lit_surface, indexed_palette);
+    // Both surfaces share a format, so padding lines up and rows can be
+    // remapped as one run.
+    size_t surface_size = static_cast<size_t>(render_surface->pitch) * render_surface->h;
 
     uint8_t* source_pixels = static_cast<uint8_t*>(render_surface->pixels);
     uint8_t* lit_pixels = static_cast<uint8_t*>(lit_surface->pixels);
 
     SDL_LockSurface(lit_surface);
 
-    // Apply light level to every pixel
-    for(size_t i = 0; i < surface_size; i++)
-    {
-        uint8_t color = source_pixels[i];
-        if((darkLevel == 8) || (color > UINT8_MAX - (32 * darkLevel)))
-        {
-            color = 255;
-        } else
-        {
-            color += (32 * darkLevel);
-        }
+    // Apply dark level and underwater in one pass
+    applyLighting(source_pixels, lit_pixels, surface_size, darkLevel, underWater);
 
-        lit_pixels[i] = color;
-    }
+    SDL_UnlockSurface(lit_surface);
 
-    SDL_DestroyTexture(render_texture);
-    render_texture = SDL_CreateTextureFromSurface(renderer, lit_surface);
+    updateRenderTexture(lit_surface);
 
-    SDL_RenderClear(renderer);
-    SDL_RenderCopy(renderer, render_texture, nullptr, nullptr);
-    SDL_RenderPresent(renderer);
+    needsRedraw = true;
 }
 
 
 
-void updateUnderwater()
+void updateLightingPalette()
 {
     if(render_surface == nullptr) { return; }
 
-    std::string render_format = SDL_GetPixelFormatName(render_surface->format->format);
-    std::cout << "Render Format: " << render_format << std::endl;
+    // Showing index i as palette[table[i]] looks the same as remapping pixels
+    const LightingTable& table = lightingTable(darkLevel, underWater);
+    std::array<SDL_Color, 256> lit_colors{};
+    for(size_t i = 0; i < lit_colors.size(); i++)
+    {
+        lit_colors[i] = indexed_palette->colors[table[i]];
+    }
 
-    size_t surface_size = lit_surface->w * lit_surface->h;
+    int err = SDL_SetPaletteColors(lit_palette, lit_colors.data(), 0, 256);
+    if(err != 0) { return; }
 
-    uint8_t* lit_pixels = static_cast<uint8_t*>(lit_surface->pixels);
+    if(render_surface->format->palette != lit_palette)
+    {
+        SDL_SetSurfacePalette(render_surface, lit_palette);
+    }
 
-    SDL_LockSurface(lit_surface);
+    updateRenderTexture(render_surface);
 
-    // Apply light level to every pixel
-    for(size_t i = 0; i < surface_size; i++)
+    needsRedraw = true;
+}
+
+
+
+/**
+ * @brief Starts rendering every lighting state of render_surface on a
+ * background thread, if --precompute-lighting is on and the results fit
+ * under the cap.
+ */
+void startLightingPrecompute()
+{
+    if(!precomputeLighting || paletteLighting || render_surface == nullptr) { return; }
+
+    size_t frame_pixels = static_cast<size_t>(render_surface->w) * render_surface->h;
+    size_t total_bytes = frame_pixels * sizeof(uint32_t) * LIGHTING_STATES;
+    if(total_bytes > precomputeCapBytes)
     {
-        uint8_t color = lit_pixels[i];
-        if(underWater)
+        std::cout << "Lighting needs " << (total_bytes >> 20) << " MiB to precompute, over the cap. "
+                  << "Lighting on demand instead." << std::endl;
+        return;
+    }
+
+    std::array<SDL_Color, 256> colors{};
+    std::copy(indexed_palette->colors, indexed_palette->colors + colors.size(), colors.begin());
+
+    precompute_cancel = false;
+    precompute_thread = std::thread([frame_pixels, colors] {
+        const SDL_Surface* surface = render_surface;
+        size_t width = static_cast<size_t>(surface->w);
+        size_t height = static_cast<size_t>(surface->h);
+        size_t rows_per_tile = std::max<size_t>(1, CONVERSION_TILE_BYTES / (width * sizeof(uint32_t)));
+        size_t tile_count = (height + rows_per_tile - 1) / rows_per_tile;
+
+        for(int state = 0; state < LIGHTING_STATES; state++)
         {
-            color |= 0x10;
+            // Lighting and palette expansion fold into one table
+            const LightingTable& table = lightingTable(state / 2, (state % 2) != 0);
+            std::array<uint32_t, 256> argb{};
+            for(size_t i = 0; i < argb.size(); i++)
+            {
+                SDL_Color color = colors[table[i]];
+                argb[i] = 0xFF000000u | (uint32_t(color.r) << 16) | (uint32_t(color.g) << 8) | color.b;
+            }
+
+            std::vector<uint32_t> frame(frame_pixels);
+            conversion_context->pool().parallelFor(tile_count, [&](size_t tile) {
+                if(precompute_cancel) { return; }
+
+                size_t begin = tile * rows_per_tile;
+                size_t end = std::min(height, begin + rows_per_tile);
+                for(size_t y = begin; y < end; y++)
+                {
+                    const uint8_t* source_row = static_cast<const uint8_t*>(surface->pixels) + (y * surface->pitch);
+                    uint32_t* dest_row = frame.data() + (y * width);
+                    for(size_t x = 0; x < width; x++)
+                    {
+                        dest_row[x] = argb[source_row[x]];
+                    }
+                }
+            });
+
+            if(precompute_cancel) { return; }
+
+            lit_frames[state] = std::move(frame);
+            lit_frame_ready[state] = true;
+
+            // Textures can only be made on the main thread
+            SDL_Event event{};
+            event.type = precompute_event;
+            SDL_PushEvent(&event);
         }
+    });
+}
+
+
 
-        lit_pixels[i] = color;
+/**
+ * @brief Stops the background lighting worker, and frees everything it made
+ */
+void stopLightingPrecompute()
+{
+    if(precompute_thread.joinable())
+    {
+        precompute_cancel = true;
+        precompute_thread.join();
     }
 
-    SDL_DestroyTexture(render_texture);
-    render_texture = SDL_CreateTextureFromSurface(renderer, lit_surface);
+    for(int state = 0; state < LIGHTING_STATES; state++)
+    {
+        SDL_DestroyTexture(lit_textures[state]);
+        lit_textures[state] = nullptr;
+        lit_frames[state] = std::vector<uint32_t>();
+        lit_frame_ready[state] = false;
+    }
+}
 
-    SDL_RenderClear(renderer);
-    SDL_RenderCopy(renderer, render_texture, nullptr, nullptr);
-    SDL_RenderPresent(renderer);
+
+
+/**
+ * @brief Turns lighting states the worker has finished into textures, and
+ * frees their pixels. Runs on the main thread.
+ */
+void uploadPrecomputedLighting()
+{
+    if(render_surface == nullptr) { return; }
+
+    for(int state = 0; state < LIGHTING_STATES; state++)
+    {
+        if(!lit_frame_ready[state] || lit_textures[state] != nullptr) { continue; }
+
+        SDL_Texture* texture = SDL_CreateTexture(
+                renderer,
+                SDL_PIXELFORMAT_ARGB8888,
+                SDL_TEXTUREACCESS_STATIC,
+                render_surface->w, render_surface->h
+        );
+        if(texture == nullptr) { continue; }
+
+        if(SDL_UpdateTexture(texture, nullptr, lit_frames[state].data(), render_surface->w * 4) != 0)
+        {
+            SDL_DestroyTexture(texture);
+            continue;
+        }
+
+        lit_textures[state] = texture;
+        lit_frames[state] = std::vector<uint32_t>();
+    }
+
+    // The state on screen may have just become available
+    needsRedraw = true;
 }
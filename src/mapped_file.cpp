@@ -0,0 +1,231 @@
+/******************************************************************************
+ * @file    src/mapped_file.cpp
+ * @project ColorTestSDL2
+ * @brief   Read-only memory mapped files
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "mapped_file.hpp"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <limits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+
+#ifdef _WIN32
+
+/**
+ * @return 0 on success, 1 on failure
+ */
+int MappedFile::open(const std::string& path)
+{
+    close();
+
+    HANDLE file = CreateFileA(
+            path.c_str(),
+            GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+    );
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        SDL_SetError("Could not open %s.", path.c_str());
+        return 1;
+    }
+
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0
+       || static_cast<unsigned long long>(file_size.QuadPart) > std::numeric_limits<size_t>::max())
+    {
+        CloseHandle(file);
+        SDL_SetError("Could not map %s.", path.c_str());
+        return 1;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if(view == nullptr)
+    {
+        if(mapping != nullptr) { CloseHandle(mapping); }
+        CloseHandle(file);
+        SDL_SetError("Could not map %s.", path.c_str());
+        return 1;
+    }
+
+    file_handle = file;
+    mapping_handle = mapping;
+    bytes = static_cast<const uint8_t*>(view);
+    length = static_cast<size_t>(file_size.QuadPart);
+
+    return 0;
+}
+
+
+
+void MappedFile::close()
+{
+    if(bytes != nullptr) { UnmapViewOfFile(bytes); }
+    if(mapping_handle != nullptr) { CloseHandle(mapping_handle); }
+    if(file_handle != nullptr) { CloseHandle(file_handle); }
+
+    bytes = nullptr;
+    length = 0;
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+}
+
+
+
+/**
+ * @brief Hints that the file will be read front to back, so the OS can
+ * read further ahead and drop pages sooner.
+ */
+void MappedFile::adviseSequential() const
+{
+    // Already asked for with FILE_FLAG_SEQUENTIAL_SCAN
+}
+
+
+
+/**
+ * @brief Asks the OS to start reading a range in the background, so it
+ * is resident by the time it is needed.
+ */
+void MappedFile::prefetch(size_t, size_t) const
+{
+    // PrefetchVirtualMemory needs Windows 8, so leave it to the fault handler
+}
+
+
+
+/**
+ * @brief Hints that a range has been used and will not be read again, so
+ * its pages no longer count against this process.
+ */
+void MappedFile::release(size_t, size_t) const
+{
+    // Windows trims the working set on its own
+}
+
+#else
+
+/**
+ * @return 0 on success, 1 on failure
+ */
+int MappedFile::open(const std::string& path)
+{
+    close();
+
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0)
+    {
+        SDL_SetError("Could not open %s.", path.c_str());
+        return 1;
+    }
+
+    struct stat info;
+    if(fstat(descriptor, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0
+       || static_cast<unsigned long long>(info.st_size) > std::numeric_limits<size_t>::max())
+    {
+        ::close(descriptor);
+        SDL_SetError("Could not map %s.", path.c_str());
+        return 1;
+    }
+
+    size_t file_size = static_cast<size_t>(info.st_size);
+    void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+    // The mapping keeps its own reference to the file
+    ::close(descriptor);
+
+    if(view == MAP_FAILED)
+    {
+        SDL_SetError("Could not map %s.", path.c_str());
+        return 1;
+    }
+
+    bytes = static_cast<const uint8_t*>(view);
+    length = file_size;
+
+    return 0;
+}
+
+
+
+void MappedFile::close()
+{
+    if(bytes != nullptr) { munmap(const_cast<uint8_t*>(bytes), length); }
+
+    bytes = nullptr;
+    length = 0;
+}
+
+
+
+/**
+ * @brief Hints that the file will be read front to back, so the OS can
+ * read further ahead and drop pages sooner.
+ */
+void MappedFile::adviseSequential() const
+{
+    if(bytes == nullptr) { return; }
+    madvise(const_cast<uint8_t*>(bytes), length, MADV_SEQUENTIAL);
+}
+
+
+
+/**
+ * @brief Asks the OS to start reading a range in the background, so it
+ * is resident by the time it is needed.
+ */
+void MappedFile::prefetch(size_t offset, size_t size) const
+{
+    if(bytes == nullptr || offset >= length) { return; }
+    size = std::min(size, length - offset);
+
+    // The start has to be page aligned
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = offset / page * page;
+
+    madvise(const_cast<uint8_t*>(bytes) + begin, size + (offset - begin), MADV_WILLNEED);
+}
+
+
+
+/**
+ * @brief Hints that a range has been used and will not be read again, so
+ * its pages no longer count against this process.
+ */
+void MappedFile::release(size_t offset, size_t size) const
+{
+    if(bytes == nullptr || offset >= length) { return; }
+    size = std::min(size, length - offset);
+
+    // Only whole pages inside the range can go
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = (offset + size) / page * page;
+    if(end <= begin) { return; }
+
+    madvise(const_cast<uint8_t*>(bytes) + begin, end - begin, MADV_DONTNEED);
+}
+
+#endif
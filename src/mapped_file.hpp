@@ -0,0 +1,69 @@
+/******************************************************************************
+ * @file    src/mapped_file.hpp
+ * @project ColorTestSDL2
+ * @brief   Read-only memory mapped files
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_MAPPED_FILE_HPP
+#define COLORTESTSDL2_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Maps a whole file read-only, so its bytes can be used in place
+ * instead of being copied into a buffer first.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @return 0 on success, 1 on failure
+     */
+    int open(const std::string& path);
+
+    void close();
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+    /**
+     * @brief Hints that the file will be read front to back, so the OS can
+     * read further ahead and drop pages sooner.
+     */
+    void adviseSequential() const;
+
+    /**
+     * @brief Asks the OS to start reading a range in the background, so it
+     * is resident by the time it is needed.
+     */
+    void prefetch(size_t offset, size_t size) const;
+
+    /**
+     * @brief Hints that a range has been used and will not be read again, so
+     * its pages no longer count against this process.
+     */
+    void release(size_t offset, size_t size) const;
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+#endif //COLORTESTSDL2_MAPPED_FILE_HPP
@@ -0,0 +1,216 @@
+/******************************************************************************
+ * @file    src/palette_file.cpp
+ * @project ColorTestSDL2
+ * @brief   Reads palettes from JASC, GIMP and Adobe color table files
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "palette_file.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t ACT_BYTES = 256 * 3;
+constexpr size_t ACT_FOOTER_BYTES = 4; // Entry count, then transparent index
+
+/**
+ * @brief Strips trailing whitespace, including the \r of CRLF files
+ */
+void trimLine(std::string& line)
+{
+    while(!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+    {
+        line.pop_back();
+    }
+}
+
+/**
+ * @brief Reads "r g b" from the start of a line. Anything after is ignored,
+ * since GIMP puts entry names there.
+ * @return 0 on success, 1 if the line does not start with three channels
+ */
+int parseEntry(const std::string& line, SDL_Color& color)
+{
+    std::istringstream stream(line);
+    int r, g, b;
+    if(!(stream >> r >> g >> b)) { return 1; }
+    if(r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) { return 1; }
+
+    color = { static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b), 0xFF };
+    return 0;
+}
+
+/**
+ * @brief JASC-PAL, as written by Paint Shop Pro and most pixel art tools: a
+ * version line, an entry count, then one entry per line
+ */
+int readJASC(std::istream& file, ColorPalette& colors)
+{
+    std::string line;
+    std::getline(file, line);
+    trimLine(line);
+    if(line != "0100")
+    {
+        SDL_SetError("Unsupported JASC palette version: %s", line.c_str());
+        return 1;
+    }
+
+    std::getline(file, line);
+    size_t count = static_cast<size_t>(std::strtoul(line.c_str(), nullptr, 10));
+    if(count == 0 || count > colors.colors.size())
+    {
+        SDL_SetError("JASC palette must have between 1 and 256 entries.");
+        return 1;
+    }
+
+    for(size_t i = 0; i < count; i++)
+    {
+        if(!std::getline(file, line) || parseEntry(line, colors.colors[i]) != 0)
+        {
+            SDL_SetError("JASC palette entry %zu is missing or invalid.", i);
+            return 1;
+        }
+    }
+    colors.count = count;
+
+    return 0;
+}
+
+/**
+ * @brief GIMP palettes: optional Name and Columns lines, # comments, then
+ * one entry per line with an optional name after it
+ */
+int readGIMP(std::istream& file, ColorPalette& colors)
+{
+    std::string line;
+    while(std::getline(file, line))
+    {
+        trimLine(line);
+        size_t first = line.find_first_not_of(" \t");
+        if(first == std::string::npos || line[first] == '#') { continue; }
+        if(line.compare(0, 5, "Name:") == 0 || line.compare(0, 8, "Columns:") == 0) { continue; }
+
+        if(colors.count == colors.colors.size())
+        {
+            SDL_SetError("GIMP palette has more than 256 entries.");
+            return 1;
+        }
+
+        if(parseEntry(line, colors.colors[colors.count]) != 0)
+        {
+            SDL_SetError("GIMP palette entry %zu is invalid.", colors.count);
+            return 1;
+        }
+        colors.count++;
+    }
+
+    if(colors.count == 0)
+    {
+        SDL_SetError("GIMP palette has no entries.");
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Adobe color tables: 256 RGB triplets and nothing else. Newer ones
+ * add a footer with how many of those are used.
+ */
+int readACT(std::istream& file, ColorPalette& colors)
+{
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if(bytes.size() != ACT_BYTES && bytes.size() != ACT_BYTES + ACT_FOOTER_BYTES)
+    {
+        SDL_SetError("File is not a JASC, GIMP or ACT palette.");
+        return 1;
+    }
+
+    size_t count = colors.colors.size();
+    if(bytes.size() > ACT_BYTES)
+    {
+        size_t used = (size_t(bytes[ACT_BYTES]) << 8) | bytes[ACT_BYTES + 1];
+
+        // Some tools write 0 or 0xFFFF to mean all of them
+        if(used > 0 && used < count) { count = used; }
+    }
+
+    for(size_t i = 0; i < count; i++)
+    {
+        colors.colors[i] = { bytes[i * 3], bytes[(i * 3) + 1], bytes[(i * 3) + 2], 0xFF };
+    }
+    colors.count = count;
+
+    return 0;
+}
+
+}
+
+/**
+ * @brief Whether a path names a palette rather than an image, by its
+ * extension: .pal, .gpl or .act
+ */
+bool isPaletteFile(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    if(dot == std::string::npos) { return false; }
+
+    std::string extension = path.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+
+    return extension == ".pal" || extension == ".gpl" || extension == ".act";
+}
+
+
+
+/**
+ * @brief Reads a palette. JASC-PAL and GIMP palettes are recognised by their
+ * first line, and anything else is read as a raw Adobe color table: 256
+ * RGB triplets, optionally followed by a big-endian entry count.
+ * @return 0 on success, 1 on failure
+ */
+int loadPaletteFile(const std::string& path, ColorPalette& colors)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file)
+    {
+        SDL_SetError("Could not open %s.", path.c_str());
+        return 1;
+    }
+
+    std::string first_line;
+    std::getline(file, first_line);
+    trimLine(first_line);
+
+    // Unused entries stay black
+    ColorPalette loaded;
+    int err;
+    if(first_line == "JASC-PAL")
+    {
+        err = readJASC(file, loaded);
+    } else if(first_line == "GIMP Palette")
+    {
+        err = readGIMP(file, loaded);
+    } else
+    {
+        file.clear();
+        file.seekg(0);
+        err = readACT(file, loaded);
+    }
+    if(err != 0) { return 1; }
+
+    colors = loaded;
+    return 0;
+}
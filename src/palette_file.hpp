@@ -0,0 +1,31 @@
+/******************************************************************************
+ * @file    src/palette_file.hpp
+ * @project ColorTestSDL2
+ * @brief   Reads palettes from JASC, GIMP and Adobe color table files
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_PALETTE_FILE_HPP
+#define COLORTESTSDL2_PALETTE_FILE_HPP
+
+#include <string>
+#include "palette.hpp"
+
+/**
+ * @brief Whether a path names a palette rather than an image, by its
+ * extension: .pal, .gpl or .act
+ */
+bool isPaletteFile(const std::string& path);
+
+/**
+ * @brief Reads a palette. JASC-PAL and GIMP palettes are recognised by their
+ * first line, and anything else is read as a raw Adobe color table: 256
+ * RGB triplets, optionally followed by a big-endian entry count.
+ * @return 0 on success, 1 on failure
+ */
+int loadPaletteFile(const std::string& path, ColorPalette& colors);
+
+#endif //COLORTESTSDL2_PALETTE_FILE_HPP
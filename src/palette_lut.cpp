@@ -0,0 +1,406 @@
+/******************************************************************************
+ * @file    src/palette_lut.cpp
+ * @project ColorTestSDL2
+ * @brief   Precomputed RGB to palette index lookup table
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "palette_lut.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace
+{
+
+constexpr int CELL_WIDTH = 1 << PaletteLUT::CELL_SHIFT;
+
+// OKLab units. Far below a visible difference, and far above rounding error.
+constexpr float OKLAB_SLACK = 1e-4f;
+
+/**
+ * @brief Squared distance from a channel value to the nearest and furthest
+ * values of the range [low, low + CELL_WIDTH - 1]
+ */
+void channelBounds(int value, int low, int64_t& nearest, int64_t& furthest)
+{
+    int high = low + CELL_WIDTH - 1;
+
+    int near_gap = 0;
+    if(value < low) { near_gap = low - value; }
+    else if(value > high) { near_gap = value - high; }
+
+    int far_gap = std::max(std::abs(value - low), std::abs(value - high));
+
+    nearest = near_gap * near_gap;
+    furthest = far_gap * far_gap;
+}
+
+/**
+ * @brief Squared distance from an OKLab value to the nearest and furthest
+ * points of the range [low, high]
+ */
+void rangeBounds(float value, float low, float high, double& nearest, double& furthest)
+{
+    double near_gap = 0;
+    if(value < low) { near_gap = low - value; }
+    else if(value > high) { near_gap = value - high; }
+
+    double far_gap = std::max(std::abs(value - low), std::abs(value - high));
+
+    nearest = near_gap * near_gap;
+    furthest = far_gap * far_gap;
+}
+
+/**
+ * @brief Integer form of paletteDistance() from an entry to the nearest and
+ * furthest colors of a cell, scaled by 100
+ */
+void weightedRGBBounds(SDL_Color color, int r, int g, int b, int64_t& nearest, int64_t& furthest)
+{
+    int64_t near_r, far_r, near_g, far_g, near_b, far_b;
+    channelBounds(color.r, r << PaletteLUT::CELL_SHIFT, near_r, far_r);
+    channelBounds(color.g, g << PaletteLUT::CELL_SHIFT, near_g, far_g);
+    channelBounds(color.b, b << PaletteLUT::CELL_SHIFT, near_b, far_b);
+
+    nearest = (near_r * 30) + (near_g * 59) + (near_b * 11);
+    furthest = (far_r * 30) + (far_g * 59) + (far_b * 11);
+}
+
+/**
+ * @brief OKLab distance from an entry to the nearest and furthest points of
+ * a cell's box
+ */
+void oklabCellBounds(OKLabColor color, OKLabColor min, OKLabColor max, double& nearest, double& furthest)
+{
+    double near_l, far_l, near_a, far_a, near_b, far_b;
+    rangeBounds(color.l, min.l, max.l, near_l, far_l);
+    rangeBounds(color.a, min.a, max.a, near_a, far_a);
+    rangeBounds(color.b, min.b, max.b, near_b, far_b);
+
+    nearest = near_l + near_a + near_b;
+    furthest = far_l + far_a + far_b;
+}
+
+/**
+ * @brief Box around a cell in OKLab, widened a little, since lookups round
+ * differently than the bounds do
+ */
+void oklabCellBox(int r, int g, int b, OKLabColor& min, OKLabColor& max)
+{
+    SDL_Color low = {
+            static_cast<uint8_t>(r << PaletteLUT::CELL_SHIFT),
+            static_cast<uint8_t>(g << PaletteLUT::CELL_SHIFT),
+            static_cast<uint8_t>(b << PaletteLUT::CELL_SHIFT)
+    };
+    SDL_Color high = {
+            static_cast<uint8_t>(low.r + CELL_WIDTH - 1),
+            static_cast<uint8_t>(low.g + CELL_WIDTH - 1),
+            static_cast<uint8_t>(low.b + CELL_WIDTH - 1)
+    };
+
+    oklabBounds(low, high, min, max);
+    min = { min.l - OKLAB_SLACK, min.a - OKLAB_SLACK, min.b - OKLAB_SLACK };
+    max = { max.l + OKLAB_SLACK, max.a + OKLAB_SLACK, max.b + OKLAB_SLACK };
+}
+
+/**
+ * @brief Adds every entry that could be the closest match for some color in
+ * a cell, by weighted RGB distance. Candidates stay in palette order.
+ * @return Furthest any color in the cell can be from its closest entry
+ */
+double addWeightedRGBCandidates(
+        const SDL_Color* colors,
+        size_t count,
+        int r, int g, int b,
+        std::vector<uint8_t>& candidates
+)
+{
+    std::array<int64_t, 256> min_distance{};
+
+    // No color in the cell can be closer to an entry than its min distance,
+    // and every color is at most upper_bound from some entry.
+    int64_t upper_bound = INT64_MAX;
+    for(size_t i = 0; i < count; i++)
+    {
+        int64_t max_distance;
+        weightedRGBBounds(colors[i], r, g, b, min_distance[i], max_distance);
+        upper_bound = std::min(upper_bound, max_distance);
+    }
+
+    // Keep ties, so lookup() can break them the same way a full
+    // search does
+    for(size_t i = 0; i < count; i++)
+    {
+        if(min_distance[i] <= upper_bound)
+        {
+            candidates.push_back(static_cast<uint8_t>(i));
+        }
+    }
+
+    return static_cast<double>(upper_bound);
+}
+
+/**
+ * @brief Adds every entry that could be the closest match for some color in
+ * a cell, by OKLab distance. Candidates are sorted by the lowest distance
+ * they could have, which goes in bounds.
+ * @param min Low corner of the cell's box, from oklabCellBox()
+ * @param max High corner of the cell's box
+ * @return Furthest any color in the cell can be from its closest entry
+ */
+double addOKLabCandidates(
+        const OKLabColor* colors,
+        size_t count,
+        OKLabColor min,
+        OKLabColor max,
+        std::vector<uint8_t>& candidates,
+        std::vector<float>& bounds
+)
+{
+    std::array<double, 256> min_distance{};
+
+    double upper_bound = INFINITY;
+    for(size_t i = 0; i < count; i++)
+    {
+        double max_distance;
+        oklabCellBounds(colors[i], min, max, min_distance[i], max_distance);
+        upper_bound = std::min(upper_bound, max_distance);
+    }
+
+    std::vector<std::pair<double, uint8_t>> cell;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(min_distance[i] <= upper_bound)
+        {
+            cell.emplace_back(min_distance[i], static_cast<uint8_t>(i));
+        }
+    }
+
+    // Likeliest first, so lookups can stop early
+    std::sort(cell.begin(), cell.end());
+    for(const auto& candidate : cell)
+    {
+        candidates.push_back(candidate.second);
+        bounds.push_back(std::nextafter(static_cast<float>(candidate.first), 0.0f));
+    }
+
+    return upper_bound;
+}
+
+/**
+ * @brief Cell coordinates of a cell index
+ */
+void cellCoordinates(size_t cell, int& r, int& g, int& b)
+{
+    constexpr size_t mask = (size_t(1) << PaletteLUT::CELL_BITS) - 1;
+    r = static_cast<int>(cell >> (PaletteLUT::CELL_BITS * 2));
+    g = static_cast<int>((cell >> PaletteLUT::CELL_BITS) & mask);
+    b = static_cast<int>(cell & mask);
+}
+
+}
+
+
+
+int PaletteLUT::build(const SDL_Color* colors, size_t count, ColorMetric metric)
+{
+    if(colors == nullptr || count == 0 || count > 256)
+    {
+        SDL_SetError("Palette must have between 1 and 256 entries.");
+        return 1;
+    }
+
+    palette_colors = {};
+    std::copy_n(colors, count, palette_colors.begin());
+    palette_count = count;
+    table_metric = metric;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        palette_lab[i] = toOKLab(colors[i]);
+    }
+
+    cell_offsets.clear();
+    cell_offsets.reserve(CELL_COUNT + 1);
+    candidates.clear();
+    candidate_bounds.clear();
+    cell_bounds.assign(CELL_COUNT, 0.0);
+
+    // The boxes only depend on the cell, so later updates reuse them
+    if(metric == ColorMetric::OKLab && cell_lab_min.size() != CELL_COUNT)
+    {
+        cell_lab_min.resize(CELL_COUNT);
+        cell_lab_max.resize(CELL_COUNT);
+        for(size_t cell = 0; cell < CELL_COUNT; cell++)
+        {
+            int r, g, b;
+            cellCoordinates(cell, r, g, b);
+            oklabCellBox(r, g, b, cell_lab_min[cell], cell_lab_max[cell]);
+        }
+    }
+
+    for(size_t cell = 0; cell < CELL_COUNT; cell++)
+    {
+        cell_offsets.push_back(static_cast<uint32_t>(candidates.size()));
+        buildCell(cell, candidates, candidate_bounds);
+    }
+
+    cell_offsets.push_back(static_cast<uint32_t>(candidates.size()));
+    candidates.shrink_to_fit();
+    candidate_bounds.shrink_to_fit();
+
+    return 0;
+}
+
+
+
+/**
+ * @brief Rebuilds the table for a changed palette, with the same metric.
+ * Only cells where a changed entry was a candidate, or could become one,
+ * are redone. Lookups give the same entries as after a full build(), but
+ * cells that were kept may hold extra candidates and looser bounds.
+ * @param colors Palette entries. Copied, so they may change afterwards.
+ * @param count Number of entries. A different count rebuilds everything.
+ * @param rebuilt_cells Number of cells redone, if not null
+ * @return 0 on success, 1 on failure
+ */
+int PaletteLUT::update(const SDL_Color* colors, size_t count, size_t* rebuilt_cells)
+{
+    if(!isBuilt() || colors == nullptr || count != palette_count)
+    {
+        if(rebuilt_cells != nullptr) { *rebuilt_cells = CELL_COUNT; }
+        return build(colors, count, table_metric);
+    }
+
+    std::vector<uint8_t> changed;
+    for(size_t i = 0; i < count; i++)
+    {
+        SDL_Color& entry = palette_colors[i];
+        if(entry.r != colors[i].r || entry.g != colors[i].g || entry.b != colors[i].b)
+        {
+            entry = colors[i];
+            palette_lab[i] = toOKLab(colors[i]);
+            changed.push_back(static_cast<uint8_t>(i));
+        }
+    }
+
+    if(rebuilt_cells != nullptr) { *rebuilt_cells = 0; }
+    if(changed.empty()) { return 0; }
+
+    // Past this, most cells are touched anyway, and checking them costs more
+    if(changed.size() > count / 8)
+    {
+        if(rebuilt_cells != nullptr) { *rebuilt_cells = CELL_COUNT; }
+        return build(colors, count, table_metric);
+    }
+
+    std::vector<uint32_t> new_offsets;
+    std::vector<uint8_t> new_candidates;
+    std::vector<float> new_bounds;
+    new_offsets.reserve(CELL_COUNT + 1);
+    new_candidates.reserve(candidates.size());
+    new_bounds.reserve(candidate_bounds.size());
+
+    size_t rebuilt = 0;
+    for(size_t cell = 0; cell < CELL_COUNT; cell++)
+    {
+        auto begin = candidates.begin() + cell_offsets[cell];
+        auto end = candidates.begin() + cell_offsets[cell + 1];
+
+        // A changed entry matters here if it was a candidate, since it may
+        // have set the bound, or if its new color could be one. Otherwise
+        // neither the bound nor the candidates move.
+        bool dirty = false;
+        for(uint8_t index : changed)
+        {
+            if(std::find(begin, end, index) != end || couldBeCandidate(cell, index))
+            {
+                dirty = true;
+                break;
+            }
+        }
+
+        new_offsets.push_back(static_cast<uint32_t>(new_candidates.size()));
+        if(dirty)
+        {
+            buildCell(cell, new_candidates, new_bounds);
+            rebuilt++;
+            continue;
+        }
+
+        new_candidates.insert(new_candidates.end(), begin, end);
+        if(table_metric == ColorMetric::OKLab)
+        {
+            auto bounds = candidate_bounds.begin() + cell_offsets[cell];
+            new_bounds.insert(new_bounds.end(), bounds, bounds + (end - begin));
+        }
+    }
+    new_offsets.push_back(static_cast<uint32_t>(new_candidates.size()));
+
+    cell_offsets = std::move(new_offsets);
+    candidates = std::move(new_candidates);
+    candidate_bounds = std::move(new_bounds);
+
+    if(rebuilt_cells != nullptr) { *rebuilt_cells = rebuilt; }
+
+    return 0;
+}
+
+
+
+double PaletteLUT::averageCandidates() const
+{
+    if(!isBuilt()) { return 0; }
+    return static_cast<double>(candidates.size()) / CELL_COUNT;
+}
+
+
+
+/**
+ * @brief Finds a cell's candidates, and records how far away its closest
+ * entry could be
+ */
+void PaletteLUT::buildCell(size_t cell, std::vector<uint8_t>& cell_candidates, std::vector<float>& cell_candidate_bounds)
+{
+    if(table_metric == ColorMetric::OKLab)
+    {
+        cell_bounds[cell] = addOKLabCandidates(
+                palette_lab.data(), palette_count,
+                cell_lab_min[cell], cell_lab_max[cell],
+                cell_candidates, cell_candidate_bounds
+        );
+        return;
+    }
+
+    int r, g, b;
+    cellCoordinates(cell, r, g, b);
+    cell_bounds[cell] = addWeightedRGBCandidates(palette_colors.data(), palette_count, r, g, b, cell_candidates);
+}
+
+
+
+/**
+ * @brief Whether an entry could be closest for some color in a cell
+ */
+bool PaletteLUT::couldBeCandidate(size_t cell, size_t index) const
+{
+    if(table_metric == ColorMetric::OKLab)
+    {
+        double nearest, furthest;
+        oklabCellBounds(palette_lab[index], cell_lab_min[cell], cell_lab_max[cell], nearest, furthest);
+        return nearest <= cell_bounds[cell];
+    }
+
+    int r, g, b;
+    cellCoordinates(cell, r, g, b);
+
+    int64_t nearest, furthest;
+    weightedRGBBounds(palette_colors[index], r, g, b, nearest, furthest);
+    return static_cast<double>(nearest) <= cell_bounds[cell];
+}
@@ -0,0 +1,167 @@
+/******************************************************************************
+ * @file    src/palette_lut.hpp
+ * @project ColorTestSDL2
+ * @brief   Precomputed RGB to palette index lookup table
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_PALETTE_LUT_HPP
+#define COLORTESTSDL2_PALETTE_LUT_HPP
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "color_metric.hpp"
+
+/**
+ * @brief Weighted euclidean distance between two colors. Green is most sensitive.
+ * @note Every nearest-color search must use this, or lookups will disagree.
+ */
+inline double paletteDistance(SDL_Color a, SDL_Color b)
+{
+    return (((a.r - b.r) * (a.r - b.r)) * 0.30)
+           + (((a.g - b.g) * (a.g - b.g)) * 0.59)
+           + (((a.b - b.b) * (a.b - b.b)) * 0.11);
+}
+
+/**
+ * @brief Splits RGB space into 32x32x32 cells, and stores every palette entry
+ * that could be the closest match for some color in each cell.
+ *
+ * A lookup only has to compare the handful of candidates in the color's cell,
+ * and returns exactly the same index as a search over the whole palette.
+ * Either metric works, and colors are only converted to OKLab when their
+ * cell has more than one candidate.
+ *
+ * Each cell also keeps the furthest its closest entry can be, so when a few
+ * entries change, update() only redoes the cells they could matter in.
+ */
+class PaletteLUT
+{
+public:
+    static constexpr int CELL_BITS = 5;
+    static constexpr int CELL_SHIFT = 8 - CELL_BITS;
+    static constexpr size_t CELL_COUNT = size_t(1) << (CELL_BITS * 3);
+
+    /**
+     * @brief Builds the table for a palette. Takes ~20ms for 256 colors.
+     * @param colors Palette entries. Copied, so they may change afterwards.
+     * @param count Number of entries, at most 256
+     * @param metric What closest means
+     * @return 0 on success, 1 on failure
+     */
+    int build(const SDL_Color* colors, size_t count, ColorMetric metric = ColorMetric::WeightedRGB);
+
+    /**
+     * @brief Rebuilds the table for a changed palette, with the same metric.
+     * Only cells where a changed entry was a candidate, or could become one,
+     * are redone. Lookups give the same entries as after a full build(), but
+     * cells that were kept may hold extra candidates and looser bounds.
+     * @param colors Palette entries. Copied, so they may change afterwards.
+     * @param count Number of entries. A different count rebuilds everything.
+     * @param rebuilt_cells Number of cells redone, if not null
+     * @return 0 on success, 1 on failure
+     */
+    int update(const SDL_Color* colors, size_t count, size_t* rebuilt_cells = nullptr);
+
+    bool isBuilt() const { return !cell_offsets.empty(); }
+
+    /**
+     * @brief Finds the closest palette entry to a color
+     */
+    uint8_t lookup(SDL_Color color) const
+    {
+        size_t cell = (size_t(color.r >> CELL_SHIFT) << (CELL_BITS * 2))
+                      | (size_t(color.g >> CELL_SHIFT) << CELL_BITS)
+                      | size_t(color.b >> CELL_SHIFT);
+
+        uint32_t begin = cell_offsets[cell];
+        uint32_t end = cell_offsets[cell + 1];
+
+        // Most cells only hold one candidate
+        uint8_t closestIndex = candidates[begin];
+        if(end - begin == 1) { return closestIndex; }
+
+        if(table_metric == ColorMetric::OKLab) { return closestOKLab(color, begin, end); }
+
+        double lowestDistance = paletteDistance(palette_colors[closestIndex], color);
+        for(uint32_t i = begin + 1; i < end; i++)
+        {
+            double distance = paletteDistance(palette_colors[candidates[i]], color);
+            if(distance < lowestDistance)
+            {
+                lowestDistance = distance;
+                closestIndex = candidates[i];
+            }
+        }
+
+        return closestIndex;
+    }
+
+    /**
+     * @brief Average number of candidates per cell. Useful for tuning.
+     */
+    double averageCandidates() const;
+
+    ColorMetric metric() const { return table_metric; }
+
+private:
+    uint8_t closestOKLab(SDL_Color color, uint32_t begin, uint32_t end) const
+    {
+        OKLabColor lab = toOKLab(color);
+
+        uint8_t closestIndex = candidates[begin];
+        float lowestDistance = oklabDistance(palette_lab[closestIndex], lab);
+        for(uint32_t i = begin + 1; i < end; i++)
+        {
+            // Sorted by how close each could be, so none of the rest can win
+            if(candidate_bounds[i] > lowestDistance) { break; }
+
+            uint8_t index = candidates[i];
+            float distance = oklabDistance(palette_lab[index], lab);
+            if(distance < lowestDistance || (distance == lowestDistance && index < closestIndex))
+            {
+                lowestDistance = distance;
+                closestIndex = index;
+            }
+        }
+
+        return closestIndex;
+    }
+
+    /**
+     * @brief Finds a cell's candidates, and records how far away its closest
+     * entry could be
+     */
+    void buildCell(size_t cell, std::vector<uint8_t>& cell_candidates, std::vector<float>& cell_candidate_bounds);
+
+    /**
+     * @brief Whether an entry could be closest for some color in a cell
+     */
+    bool couldBeCandidate(size_t cell, size_t index) const;
+
+    std::array<SDL_Color, 256> palette_colors{};
+    size_t palette_count = 0;
+    ColorMetric table_metric = ColorMetric::WeightedRGB;
+    std::array<OKLabColor, 256> palette_lab{};
+    std::vector<uint32_t> cell_offsets;
+    std::vector<uint8_t> candidates;
+
+    // OKLab only. Lowest distance any color in the cell could have to each
+    // candidate, which are sorted by it.
+    std::vector<float> candidate_bounds;
+
+    // Furthest any color in each cell can be from its closest entry
+    std::vector<double> cell_bounds;
+
+    // OKLab only. Box around each cell in OKLab, widened by the slack.
+    std::vector<OKLabColor> cell_lab_min;
+    std::vector<OKLabColor> cell_lab_max;
+};
+
+#endif //COLORTESTSDL2_PALETTE_LUT_HPP
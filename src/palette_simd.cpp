@@ -0,0 +1,252 @@
+/******************************************************************************
+ * @file    src/palette_simd.cpp
+ * @project ColorTestSDL2
+ * @brief   Vectorized nearest palette entry search
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "palette_simd.hpp"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLORTEST_X86 1
+#include <immintrin.h>
+#endif
+
+// MSVC allows intrinsics anywhere, GCC and Clang need them enabled per function.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+
+constexpr int32_t WEIGHT_R = 30;
+constexpr int32_t WEIGHT_G = 59;
+constexpr int32_t WEIGHT_B = 11;
+
+// Far enough that padding never wins, close enough not to overflow int32
+constexpr int32_t PADDING_VALUE = 1000;
+
+#ifdef COLORTEST_X86
+
+/**
+ * @brief Reduces per-lane results. Returns -1 unless exactly one entry has
+ * the lowest distance.
+ */
+int reduceLanes(const int32_t* best, const int32_t* best_index, const int32_t* tied, int lanes)
+{
+    int32_t lowest = best[0];
+    for(int i = 1; i < lanes; i++)
+    {
+        if(best[i] < lowest) { lowest = best[i]; }
+    }
+
+    int winner = -1;
+    for(int i = 0; i < lanes; i++)
+    {
+        if(best[i] != lowest) { continue; }
+        if(winner != -1 || tied[i] != 0) { return -1; }
+        winner = best_index[i];
+    }
+
+    return winner;
+}
+
+
+
+TARGET_SSE41
+int findNearestSSE41(const PaletteSoA& soa, SDL_Color color)
+{
+    const __m128i cr = _mm_set1_epi32(color.r);
+    const __m128i cg = _mm_set1_epi32(color.g);
+    const __m128i cb = _mm_set1_epi32(color.b);
+    const __m128i wr = _mm_set1_epi32(WEIGHT_R);
+    const __m128i wg = _mm_set1_epi32(WEIGHT_G);
+    const __m128i wb = _mm_set1_epi32(WEIGHT_B);
+    const __m128i step = _mm_set1_epi32(4);
+
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i best = _mm_set1_epi32(INT32_MAX);
+    __m128i best_index = _mm_setzero_si128();
+    __m128i tied = _mm_setzero_si128();
+
+    for(size_t i = 0; i < soa.padded_count; i += 4)
+    {
+        __m128i dr = _mm_sub_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(soa.r + i)), cr);
+        __m128i dg = _mm_sub_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(soa.g + i)), cg);
+        __m128i db = _mm_sub_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(soa.b + i)), cb);
+
+        __m128i distance = _mm_add_epi32(
+                _mm_add_epi32(
+                        _mm_mullo_epi32(_mm_mullo_epi32(dr, dr), wr),
+                        _mm_mullo_epi32(_mm_mullo_epi32(dg, dg), wg)),
+                _mm_mullo_epi32(_mm_mullo_epi32(db, db), wb));
+
+        // A new minimum clears the tie flag, an equal distance sets it
+        __m128i lower = _mm_cmpgt_epi32(best, distance);
+        __m128i equal = _mm_cmpeq_epi32(best, distance);
+        tied = _mm_andnot_si128(lower, _mm_or_si128(tied, equal));
+        best_index = _mm_blendv_epi8(best_index, index, lower);
+        best = _mm_min_epi32(best, distance);
+
+        index = _mm_add_epi32(index, step);
+    }
+
+    alignas(16) int32_t lanes_best[4];
+    alignas(16) int32_t lanes_index[4];
+    alignas(16) int32_t lanes_tied[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes_best), best);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes_index), best_index);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes_tied), tied);
+
+    return reduceLanes(lanes_best, lanes_index, lanes_tied, 4);
+}
+
+
+
+TARGET_AVX2
+int findNearestAVX2(const PaletteSoA& soa, SDL_Color color)
+{
+    const __m256i cr = _mm256_set1_epi32(color.r);
+    const __m256i cg = _mm256_set1_epi32(color.g);
+    const __m256i cb = _mm256_set1_epi32(color.b);
+    const __m256i wr = _mm256_set1_epi32(WEIGHT_R);
+    const __m256i wg = _mm256_set1_epi32(WEIGHT_G);
+    const __m256i wb = _mm256_set1_epi32(WEIGHT_B);
+    const __m256i step = _mm256_set1_epi32(8);
+
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i best = _mm256_set1_epi32(INT32_MAX);
+    __m256i best_index = _mm256_setzero_si256();
+    __m256i tied = _mm256_setzero_si256();
+
+    for(size_t i = 0; i < soa.padded_count; i += 8)
+    {
+        __m256i dr = _mm256_sub_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(soa.r + i)), cr);
+        __m256i dg = _mm256_sub_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(soa.g + i)), cg);
+        __m256i db = _mm256_sub_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(soa.b + i)), cb);
+
+        __m256i distance = _mm256_add_epi32(
+                _mm256_add_epi32(
+                        _mm256_mullo_epi32(_mm256_mullo_epi32(dr, dr), wr),
+                        _mm256_mullo_epi32(_mm256_mullo_epi32(dg, dg), wg)),
+                _mm256_mullo_epi32(_mm256_mullo_epi32(db, db), wb));
+
+        __m256i lower = _mm256_cmpgt_epi32(best, distance);
+        __m256i equal = _mm256_cmpeq_epi32(best, distance);
+        tied = _mm256_andnot_si256(lower, _mm256_or_si256(tied, equal));
+        best_index = _mm256_blendv_epi8(best_index, index, lower);
+        best = _mm256_min_epi32(best, distance);
+
+        index = _mm256_add_epi32(index, step);
+    }
+
+    alignas(32) int32_t lanes_best[8];
+    alignas(32) int32_t lanes_index[8];
+    alignas(32) int32_t lanes_tied[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes_best), best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes_index), best_index);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes_tied), tied);
+
+    return reduceLanes(lanes_best, lanes_index, lanes_tied, 8);
+}
+
+#endif // COLORTEST_X86
+
+}
+
+
+
+int buildPaletteSoA(const SDL_Color* colors, size_t count, PaletteSoA& soa)
+{
+    if(colors == nullptr || count == 0 || count > 256)
+    {
+        SDL_SetError("Palette must have between 1 and 256 entries.");
+        return 1;
+    }
+
+    soa.count = count;
+    soa.padded_count = (count + 7) & ~size_t(7);
+
+    for(size_t i = 0; i < 256; i++)
+    {
+        if(i < count)
+        {
+            soa.r[i] = colors[i].r;
+            soa.g[i] = colors[i].g;
+            soa.b[i] = colors[i].b;
+        } else
+        {
+            soa.r[i] = PADDING_VALUE;
+            soa.g[i] = PADDING_VALUE;
+            soa.b[i] = PADDING_VALUE;
+        }
+    }
+
+    return 0;
+}
+
+
+
+int findNearestScalar(const PaletteSoA& soa, SDL_Color color)
+{
+    int32_t lowestDistance = INT32_MAX;
+    int closestIndex = -1;
+    bool tied = false;
+
+    for(size_t i = 0; i < soa.count; i++)
+    {
+        int32_t dr = soa.r[i] - color.r;
+        int32_t dg = soa.g[i] - color.g;
+        int32_t db = soa.b[i] - color.b;
+        int32_t distance = (dr * dr * WEIGHT_R) + (dg * dg * WEIGHT_G) + (db * db * WEIGHT_B);
+
+        if(distance < lowestDistance)
+        {
+            lowestDistance = distance;
+            closestIndex = static_cast<int>(i);
+            tied = false;
+        } else if(distance == lowestDistance)
+        {
+            tied = true;
+        }
+    }
+
+    return tied ? -1 : closestIndex;
+}
+
+
+
+NearestKernel selectNearestKernel()
+{
+#ifdef COLORTEST_X86
+    static const NearestKernel kernel =
+            SDL_HasAVX2() ? findNearestAVX2
+            : SDL_HasSSE41() ? findNearestSSE41
+            : findNearestScalar;
+    return kernel;
+#else
+    return findNearestScalar;
+#endif
+}
+
+
+
+const char* nearestKernelName()
+{
+    NearestKernel kernel = selectNearestKernel();
+#ifdef COLORTEST_X86
+    if(kernel == findNearestAVX2) { return "AVX2"; }
+    if(kernel == findNearestSSE41) { return "SSE4.1"; }
+#endif
+    (void)kernel;
+    return "Scalar";
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+ * @file    src/palette_simd.hpp
+ * @project ColorTestSDL2
+ * @brief   Vectorized nearest palette entry search
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_PALETTE_SIMD_HPP
+#define COLORTESTSDL2_PALETTE_SIMD_HPP
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Palette in structure-of-arrays form, padded to a multiple of 8
+ * entries so kernels never need a remainder loop.
+ */
+struct PaletteSoA
+{
+    alignas(32) int32_t r[256];
+    alignas(32) int32_t g[256];
+    alignas(32) int32_t b[256];
+    size_t count = 0;
+    size_t padded_count = 0;
+};
+
+/**
+ * @brief Fills a PaletteSoA from a palette
+ * @param colors Palette entries
+ * @param count Number of entries, at most 256
+ * @return 0 on success, 1 on failure
+ */
+int buildPaletteSoA(const SDL_Color* colors, size_t count, PaletteSoA& soa);
+
+/**
+ * @brief Finds the closest palette entry using the weighted distance in
+ * fixed point (30/59/11), so every kernel gives the same answer.
+ * @return Closest index, or -1 if several entries are equally close. The
+ * caller must then break the tie with paletteDistance().
+ */
+using NearestKernel = int (*)(const PaletteSoA& soa, SDL_Color color);
+
+/**
+ * @brief Portable kernel. Used as the fallback and as the reference for the
+ * vectorized kernels.
+ */
+int findNearestScalar(const PaletteSoA& soa, SDL_Color color);
+
+/**
+ * @brief Picks the fastest kernel the CPU supports. Checked once.
+ */
+NearestKernel selectNearestKernel();
+
+/**
+ * @brief Name of the kernel selectNearestKernel() returns, for logging
+ */
+const char* nearestKernelName();
+
+#endif //COLORTESTSDL2_PALETTE_SIMD_HPP
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * @file    src/palette_tree.cpp
+ * @project ColorTestSDL2
+ * @brief   k-d tree over the palette for exact nearest color searches
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "palette_tree.hpp"
+#include <algorithm>
+#include <limits>
+#include "palette_lut.hpp"
+
+namespace
+{
+
+/**
+ * @brief One channel's term of paletteDistance(), computed the same way, so
+ * it is never more than the full distance after rounding.
+ */
+double channelDistance(int axis, int difference)
+{
+    constexpr double weights[3] = { 0.30, 0.59, 0.11 };
+    return (difference * difference) * weights[axis];
+}
+
+}
+
+/**
+ * @brief Builds the tree for a palette
+ * @param colors Palette entries
+ * @param count Number of entries, at most 256
+ * @return 0 on success, 1 on failure
+ */
+int PaletteTree::build(const SDL_Color* colors, size_t count)
+{
+    if(colors == nullptr || count == 0 || count > 256)
+    {
+        SDL_SetError("Palette must have between 1 and 256 entries.");
+        return 1;
+    }
+
+    nodes.clear();
+    nodes.reserve(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        nodes.push_back({ { colors[i].r, colors[i].g, colors[i].b }, static_cast<uint8_t>(i), 0 });
+    }
+
+    split(0, nodes.size());
+
+    return 0;
+}
+
+
+
+/**
+ * @brief Finds the closest palette entry to a color
+ * @param visited Incremented once per entry compared, if not null. Useful
+ * for tuning.
+ */
+uint8_t PaletteTree::nearest(SDL_Color color, size_t* visited) const
+{
+    const uint8_t channels[3] = { color.r, color.g, color.b };
+
+    Match best = { std::numeric_limits<double>::infinity(), 0 };
+    size_t count = 0;
+    search(0, nodes.size(), channels, color, best, count);
+
+    if(visited != nullptr) { *visited += count; }
+
+    return best.index;
+}
+
+
+
+void PaletteTree::split(size_t begin, size_t end)
+{
+    if(end - begin < 2) { return; }
+
+    // Split on the channel where the entries are furthest apart
+    int axis = 0;
+    double widest = -1;
+    for(int channel = 0; channel < 3; channel++)
+    {
+        auto range = std::minmax_element(
+                nodes.begin() + begin, nodes.begin() + end,
+                [channel](const Node& a, const Node& b) { return a.channels[channel] < b.channels[channel]; }
+        );
+        double spread = channelDistance(channel, range.second->channels[channel] - range.first->channels[channel]);
+        if(spread > widest)
+        {
+            widest = spread;
+            axis = channel;
+        }
+    }
+
+    size_t middle = begin + ((end - begin) / 2);
+    std::nth_element(
+            nodes.begin() + begin, nodes.begin() + middle, nodes.begin() + end,
+            [axis](const Node& a, const Node& b) { return a.channels[axis] < b.channels[axis]; }
+    );
+    nodes[middle].axis = static_cast<uint8_t>(axis);
+
+    split(begin, middle);
+    split(middle + 1, end);
+}
+
+
+
+void PaletteTree::search(
+        size_t begin,
+        size_t end,
+        const uint8_t* channels,
+        SDL_Color color,
+        Match& best,
+        size_t& visited
+) const
+{
+    if(begin >= end) { return; }
+
+    size_t middle = begin + ((end - begin) / 2);
+    const Node& node = nodes[middle];
+    visited++;
+
+    // Lower indices win ties, like a search in palette order
+    SDL_Color entry = { node.channels[0], node.channels[1], node.channels[2] };
+    double distance = paletteDistance(entry, color);
+    if(distance < best.distance || (distance == best.distance && node.index < best.index))
+    {
+        best = { distance, node.index };
+    }
+
+    if(end - begin == 1) { return; }
+
+    // Everything on the far side is at least this far away on the split
+    // channel alone. Equal is not enough to skip it, since it could win a tie.
+    int difference = channels[node.axis] - node.channels[node.axis];
+    bool lower_first = difference < 0;
+
+    if(lower_first) { search(begin, middle, channels, color, best, visited); }
+    else { search(middle + 1, end, channels, color, best, visited); }
+
+    if(channelDistance(node.axis, difference) <= best.distance)
+    {
+        if(lower_first) { search(middle + 1, end, channels, color, best, visited); }
+        else { search(begin, middle, channels, color, best, visited); }
+    }
+}
@@ -0,0 +1,69 @@
+/******************************************************************************
+ * @file    src/palette_tree.hpp
+ * @project ColorTestSDL2
+ * @brief   k-d tree over the palette for exact nearest color searches
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_PALETTE_TREE_HPP
+#define COLORTESTSDL2_PALETTE_TREE_HPP
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Balanced k-d tree over the palette, split on whichever channel has
+ * the widest weighted spread. The palette is a grid of hue columns and
+ * brightness rows, so most branches can be ruled out from one channel.
+ *
+ * A search returns exactly the same index as a search over the whole palette
+ * with paletteDistance(), including which entry wins a tie.
+ */
+class PaletteTree
+{
+public:
+    /**
+     * @brief Builds the tree for a palette
+     * @param colors Palette entries
+     * @param count Number of entries, at most 256
+     * @return 0 on success, 1 on failure
+     */
+    int build(const SDL_Color* colors, size_t count);
+
+    bool isBuilt() const { return !nodes.empty(); }
+
+    /**
+     * @brief Finds the closest palette entry to a color
+     * @param visited Incremented once per entry compared, if not null. Useful
+     * for tuning.
+     */
+    uint8_t nearest(SDL_Color color, size_t* visited = nullptr) const;
+
+private:
+    struct Node
+    {
+        uint8_t channels[3];
+        uint8_t index; // Into the palette
+        uint8_t axis;  // Channel the children are split on
+    };
+
+    struct Match
+    {
+        double distance;
+        uint8_t index;
+    };
+
+    void split(size_t begin, size_t end);
+    void search(size_t begin, size_t end, const uint8_t* channels, SDL_Color color, Match& best, size_t& visited) const;
+
+    // Stored in place: each range's middle node is its root, with the lower
+    // half of the range on one side and the upper half on the other
+    std::vector<Node> nodes;
+};
+
+#endif //COLORTESTSDL2_PALETTE_TREE_HPP
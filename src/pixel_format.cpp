@@ -0,0 +1,93 @@
+/******************************************************************************
+ * @file    src/pixel_format.cpp
+ * @project ColorTestSDL2
+ * @brief   Per-format pixel readers for the conversion kernels
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "pixel_format.hpp"
+
+namespace
+{
+
+/**
+ * @brief Byte a channel of a packed 32-bit pixel sits in, in memory
+ */
+size_t channelByte(uint8_t shift)
+{
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    return shift / 8;
+#else
+    return 3 - (shift / 8);
+#endif
+}
+
+}
+
+
+
+/**
+ * @brief Finds the kernel for an SDL pixel format
+ * @return 0 if the format has one, 1 if it needs converting first
+ */
+int pixelLayoutOf(const SDL_PixelFormat* format, PixelLayout& layout)
+{
+    switch(format->format)
+    {
+    case SDL_PIXELFORMAT_BGR24: layout = PixelLayout::BGR24; return 0;
+    case SDL_PIXELFORMAT_RGB24: layout = PixelLayout::RGB24; return 0;
+    case SDL_PIXELFORMAT_RGB565: layout = PixelLayout::RGB565; return 0;
+
+    case SDL_PIXELFORMAT_INDEX8:
+    {
+        if(format->palette == nullptr) { return 1; }
+        layout = PixelLayout::Index8;
+        return 0;
+    }
+
+    default: break;
+    }
+
+    // 32-bit formats are named by their packed value, so go by which byte
+    // each channel lands in
+    if(format->BytesPerPixel != 4) { return 1; }
+    if(format->Rshift % 8 != 0 || format->Gshift % 8 != 0 || format->Bshift % 8 != 0) { return 1; }
+
+    size_t r = channelByte(format->Rshift);
+    size_t g = channelByte(format->Gshift);
+    size_t b = channelByte(format->Bshift);
+
+    if(r == 2 && g == 1 && b == 0)
+    {
+        layout = PixelLayout::BGRX32;
+        return 0;
+    }
+
+    if(r == 0 && g == 1 && b == 2)
+    {
+        layout = PixelLayout::RGBX32;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+
+size_t pixelLayoutBytes(PixelLayout layout)
+{
+    switch(layout)
+    {
+    case PixelLayout::BGR24:
+    case PixelLayout::RGB24: return 3;
+    case PixelLayout::BGRX32:
+    case PixelLayout::RGBX32: return 4;
+    case PixelLayout::RGB565: return 2;
+    case PixelLayout::Index8: return 1;
+    }
+
+    return 1;
+}
@@ -0,0 +1,115 @@
+/******************************************************************************
+ * @file    src/pixel_format.hpp
+ * @project ColorTestSDL2
+ * @brief   Per-format pixel readers for the conversion kernels
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_PIXEL_FORMAT_HPP
+#define COLORTESTSDL2_PIXEL_FORMAT_HPP
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief Source layouts with their own conversion kernel. Byte formats are
+ * named by their order in memory.
+ */
+enum class PixelLayout
+{
+    BGR24,
+    RGB24,
+    BGRX32,
+    RGBX32,
+    RGB565,
+    Index8
+};
+
+/**
+ * @brief Reads pixels of R, G and B bytes at fixed offsets
+ */
+template<size_t R, size_t G, size_t B, size_t BYTES>
+struct BytePixelReader
+{
+    static constexpr size_t BYTES_PER_PIXEL = BYTES;
+
+    SDL_Color operator()(const uint8_t* row, size_t x) const
+    {
+        const uint8_t* pixel = row + (x * BYTES);
+        return { pixel[R], pixel[G], pixel[B], 0xFF };
+    }
+};
+
+/**
+ * @brief Reads native-endian 5-6-5 pixels, widened the same way SDL does
+ */
+struct RGB565PixelReader
+{
+    static constexpr size_t BYTES_PER_PIXEL = 2;
+
+    SDL_Color operator()(const uint8_t* row, size_t x) const
+    {
+        uint16_t value;
+        std::memcpy(&value, row + (x * 2), sizeof(value));
+
+        uint8_t r = static_cast<uint8_t>(value >> 11);
+        uint8_t g = static_cast<uint8_t>((value >> 5) & 0x3F);
+        uint8_t b = static_cast<uint8_t>(value & 0x1F);
+
+        return {
+                static_cast<uint8_t>((r << 3) | (r >> 2)),
+                static_cast<uint8_t>((g << 2) | (g >> 4)),
+                static_cast<uint8_t>((b << 3) | (b >> 2)),
+                0xFF
+        };
+    }
+};
+
+/**
+ * @brief Reads 8-bit indices through the source's own palette
+ */
+struct Index8PixelReader
+{
+    static constexpr size_t BYTES_PER_PIXEL = 1;
+
+    const SDL_Color* colors; // 256 entries
+
+    SDL_Color operator()(const uint8_t* row, size_t x) const
+    {
+        return colors[row[x]];
+    }
+};
+
+/**
+ * @brief Finds the kernel for an SDL pixel format
+ * @return 0 if the format has one, 1 if it needs converting first
+ */
+int pixelLayoutOf(const SDL_PixelFormat* format, PixelLayout& layout);
+
+size_t pixelLayoutBytes(PixelLayout layout);
+
+/**
+ * @brief Calls function with the reader for a layout, so the loop inside it
+ * is compiled once per format.
+ * @param colors 256 entry source palette. Only used by Index8.
+ */
+template<typename Function>
+void withPixelReader(PixelLayout layout, const SDL_Color* colors, Function&& function)
+{
+    switch(layout)
+    {
+    case PixelLayout::BGR24: function(BytePixelReader<2, 1, 0, 3>()); break;
+    case PixelLayout::RGB24: function(BytePixelReader<0, 1, 2, 3>()); break;
+    case PixelLayout::BGRX32: function(BytePixelReader<2, 1, 0, 4>()); break;
+    case PixelLayout::RGBX32: function(BytePixelReader<0, 1, 2, 4>()); break;
+    case PixelLayout::RGB565: function(RGB565PixelReader()); break;
+    case PixelLayout::Index8: function(Index8PixelReader{ colors }); break;
+    }
+}
+
+#endif //COLORTESTSDL2_PIXEL_FORMAT_HPP
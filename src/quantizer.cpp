@@ -0,0 +1,66 @@
+/******************************************************************************
+ * @file    src/quantizer.cpp
+ * @project ColorTestSDL2
+ * @brief   Nearest palette entry kernels specialized per metric and palette
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "quantizer.hpp"
+#include <algorithm>
+
+namespace
+{
+
+template<typename Metric, typename Palette>
+QuantizerVariant makeVariant(const char* name)
+{
+    return {
+            name,
+            Metric::id,
+            Palette::colors.data(),
+            Palette::colors.size(),
+            &PaletteQuantizer<Metric, Palette>::nearest
+    };
+}
+
+}
+
+/**
+ * @brief Every compiled-in variant
+ */
+const std::vector<QuantizerVariant>& quantizerVariants()
+{
+    // New metrics and built-in palettes are instantiated here
+    static const std::vector<QuantizerVariant> variants = {
+            makeVariant<WeightedRGBMetric, DefaultPalette>("rgb/default"),
+            makeVariant<OKLabMetric, DefaultPalette>("oklab/default")
+    };
+
+    return variants;
+}
+
+
+
+/**
+ * @brief Finds the variant for a metric and palette. Palettes are matched by
+ * their colors, so a palette loaded at runtime only has one if it is a copy
+ * of a built-in palette.
+ * @return The variant, or nullptr if there is none
+ */
+const QuantizerVariant* findQuantizer(ColorMetric metric, const SDL_Color* colors, size_t count)
+{
+    for(const QuantizerVariant& variant : quantizerVariants())
+    {
+        if(variant.metric != metric || variant.palette_size != count) { continue; }
+
+        bool same = std::equal(colors, colors + count, variant.palette_colors, [](SDL_Color a, SDL_Color b) {
+            return a.r == b.r && a.g == b.g && a.b == b.b;
+        });
+        if(same) { return &variant; }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,238 @@
+/******************************************************************************
+ * @file    src/quantizer.hpp
+ * @project ColorTestSDL2
+ * @brief   Nearest palette entry kernels specialized per metric and palette
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_QUANTIZER_HPP
+#define COLORTESTSDL2_QUANTIZER_HPP
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "color_metric.hpp"
+#include "palette.hpp"
+#include "palette_lut.hpp"
+
+/**
+ * @brief Weighted RGB in fixed point (30/59/11). The palette table is built
+ * at compile time.
+ *
+ * The largest distance is under 2^24, so floats hold every one exactly.
+ * Baseline SSE2 has no 32-bit integer multiply, but multiplies floats fast.
+ */
+struct WeightedRGBMetric
+{
+    static constexpr ColorMetric id = ColorMetric::WeightedRGB;
+
+    using Query = SDL_Color;
+
+    template<size_t N>
+    struct Points
+    {
+        float r[N];
+        float g[N];
+        float b[N];
+    };
+
+    template<size_t N>
+    static constexpr Points<N> project(const std::array<SDL_Color, N>& colors)
+    {
+        Points<N> points{};
+        for(size_t i = 0; i < N; i++)
+        {
+            points.r[i] = colors[i].r;
+            points.g[i] = colors[i].g;
+            points.b[i] = colors[i].b;
+        }
+        return points;
+    }
+
+    template<typename Palette>
+    static const auto& points()
+    {
+        static constexpr auto table = project(Palette::colors);
+        return table;
+    }
+
+    static Query prepare(SDL_Color color) { return color; }
+
+    template<size_t N>
+    static uint32_t key(const Points<N>& points, size_t i, Query color)
+    {
+        float dr = points.r[i] - color.r;
+        float dg = points.g[i] - color.g;
+        float db = points.b[i] - color.b;
+        // Through int32, since SSE2 can only convert floats to signed ints
+        return static_cast<uint32_t>(static_cast<int32_t>((dr * dr * 30.0f) + (dg * dg * 59.0f) + (db * db * 11.0f)));
+    }
+
+    /**
+     * @brief Settles a tie in fixed point the way paletteDistance() would
+     */
+    static bool closerOnTie(SDL_Color entry, SDL_Color current, SDL_Color color)
+    {
+        return paletteDistance(entry, color) < paletteDistance(current, color);
+    }
+};
+
+/**
+ * @brief Euclidean distance in OKLab. toOKLab() is not constexpr, so the
+ * palette table is built the first time it is used.
+ */
+struct OKLabMetric
+{
+    static constexpr ColorMetric id = ColorMetric::OKLab;
+
+    using Query = OKLabColor;
+
+    template<size_t N>
+    struct Points
+    {
+        float l[N];
+        float a[N];
+        float b[N];
+    };
+
+    template<size_t N>
+    static Points<N> project(const std::array<SDL_Color, N>& colors)
+    {
+        Points<N> points{};
+        for(size_t i = 0; i < N; i++)
+        {
+            OKLabColor lab = toOKLab(colors[i]);
+            points.l[i] = lab.l;
+            points.a[i] = lab.a;
+            points.b[i] = lab.b;
+        }
+        return points;
+    }
+
+    template<typename Palette>
+    static const auto& points()
+    {
+        static const auto table = project(Palette::colors);
+        return table;
+    }
+
+    static Query prepare(SDL_Color color) { return toOKLab(color); }
+
+    // Distances are never negative, so their bits sort the same way
+    template<size_t N>
+    static uint32_t key(const Points<N>& points, size_t i, Query lab)
+    {
+        float distance = oklabDistance({ points.l[i], points.a[i], points.b[i] }, lab);
+
+        uint32_t bits;
+        std::memcpy(&bits, &distance, sizeof(bits));
+        return bits;
+    }
+
+    // Float distances are compared exactly, so the first entry already wins
+    static bool closerOnTie(SDL_Color, SDL_Color, SDL_Color) { return false; }
+};
+
+/**
+ * @brief The built-in palette
+ */
+struct DefaultPalette
+{
+    static constexpr const std::array<SDL_Color, 256>& colors = palette;
+};
+
+/**
+ * @brief Exact nearest palette entry search for one metric and one palette.
+ * The palette size and weights are constants, so the compiler can unroll and
+ * vectorize the loops. Metrics hand back each distance as an unsigned key
+ * that sorts the same way, so every metric shares one integer search.
+ */
+template<typename Metric, typename Palette>
+class PaletteQuantizer
+{
+public:
+    static constexpr size_t COUNT = Palette::colors.size();
+    static_assert(COUNT > 0 && COUNT <= 256, "Palette must have between 1 and 256 entries.");
+
+    /**
+     * @brief Same index as a search over the whole palette, ties included
+     */
+    static uint8_t nearest(SDL_Color color)
+    {
+        const auto& points = Metric::template points<Palette>();
+        typename Metric::Query query = Metric::prepare(color);
+
+        // Every distance, then the lowest. No branches, so both vectorize.
+        uint32_t keys[COUNT];
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            keys[i] = Metric::key(points, i, query);
+        }
+
+        uint32_t lowest = UINT32_MAX;
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            lowest = std::min(lowest, keys[i]);
+        }
+
+        // First entry at that distance, and how many share it
+        uint32_t first = COUNT;
+        uint32_t tied = 0;
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            uint32_t match = (keys[i] == lowest) ? 1 : 0;
+            first = std::min(first, match ? static_cast<uint32_t>(i) : static_cast<uint32_t>(COUNT));
+            tied += match;
+        }
+
+        if(tied == 1) { return static_cast<uint8_t>(first); }
+
+        // Rare. Settle it the way a full search would.
+        size_t closest = first;
+        for(size_t i = first + 1; i < COUNT; i++)
+        {
+            if(keys[i] == lowest && Metric::closerOnTie(Palette::colors[i], Palette::colors[closest], color))
+            {
+                closest = i;
+            }
+        }
+
+        return static_cast<uint8_t>(closest);
+    }
+};
+
+using QuantizeFunction = uint8_t (*)(SDL_Color color);
+
+/**
+ * @brief One compiled-in metric and palette pair
+ */
+struct QuantizerVariant
+{
+    const char* name;
+    ColorMetric metric;
+    const SDL_Color* palette_colors;
+    size_t palette_size;
+    QuantizeFunction nearest;
+};
+
+/**
+ * @brief Every compiled-in variant
+ */
+const std::vector<QuantizerVariant>& quantizerVariants();
+
+/**
+ * @brief Finds the variant for a metric and palette. Palettes are matched by
+ * their colors, so a palette loaded at runtime only has one if it is a copy
+ * of a built-in palette.
+ * @return The variant, or nullptr if there is none
+ */
+const QuantizerVariant* findQuantizer(ColorMetric metric, const SDL_Color* colors, size_t count);
+
+#endif //COLORTESTSDL2_QUANTIZER_HPP
@@ -0,0 +1,67 @@
+/******************************************************************************
+ * @file    src/spsc_queue.hpp
+ * @project ColorTestSDL2
+ * @brief   Lock-free queue between exactly one producer and one consumer
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_SPSC_QUEUE_HPP
+#define COLORTESTSDL2_SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Fixed-size ring buffer. One thread may push and one other thread may
+ * pop, without either ever taking a lock or waiting on the other.
+ * @tparam CAPACITY Power of two. One slot is kept empty to tell full from empty.
+ */
+template<typename T, size_t CAPACITY>
+class SPSCQueue
+{
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+public:
+    /**
+     * @brief Producer only
+     * @return false if the queue is full. value is left untouched.
+     */
+    bool tryPush(T&& value)
+    {
+        size_t tail = write_index.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & (CAPACITY - 1);
+        if(next == read_index.load(std::memory_order_acquire)) { return false; }
+
+        slots[tail] = std::move(value);
+        write_index.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer only
+     * @return false if the queue is empty
+     */
+    bool tryPop(T& value)
+    {
+        size_t head = read_index.load(std::memory_order_relaxed);
+        if(head == write_index.load(std::memory_order_acquire)) { return false; }
+
+        value = std::move(slots[head]);
+        read_index.store((head + 1) & (CAPACITY - 1), std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, CAPACITY> slots{};
+
+    // Apart, so the two threads do not fight over one cache line
+    alignas(64) std::atomic<size_t> write_index{0};
+    alignas(64) std::atomic<size_t> read_index{0};
+};
+
+#endif //COLORTESTSDL2_SPSC_QUEUE_HPP
@@ -0,0 +1,211 @@
+/******************************************************************************
+ * @file    src/thread_pool.cpp
+ * @project ColorTestSDL2
+ * @brief   Work-stealing worker pool for splitting pixel loops across cores
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace
+{
+
+// Which pool and queue the current thread owns, if it is a worker
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+/**
+ * @brief Shared by a parallelFor and its helper tasks. Helpers can still be
+ * queued after parallelFor returns, so this outlives the call.
+ */
+struct LoopState
+{
+    const std::function<void(size_t)>* task = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> finished{0};
+
+    std::mutex mutex;
+    std::condition_variable done;
+
+    /**
+     * @brief Claims and runs indices until there are none left
+     */
+    void run()
+    {
+        while(true)
+        {
+            size_t index = next.fetch_add(1);
+            if(index >= count) { return; }
+
+            (*task)(index);
+
+            if(finished.fetch_add(1) + 1 == count)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+};
+
+}
+
+
+
+ThreadPool::ThreadPool(unsigned thread_count)
+{
+    if(thread_count == 0) { thread_count = std::thread::hardware_concurrency(); }
+    if(thread_count == 0) { thread_count = 1; }
+
+    for(unsigned i = 0; i < thread_count; i++)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    // The thread calling parallelFor is the last worker
+    for(unsigned i = 1; i < thread_count; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i - 1);
+    }
+}
+
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task)
+{
+    if(count == 0) { return; }
+
+    // Not worth waking anyone
+    if(count == 1 || workers.empty())
+    {
+        for(size_t i = 0; i < count; i++) { task(i); }
+        return;
+    }
+
+    auto state = std::make_shared<LoopState>();
+    state->task = &task;
+    state->count = count;
+
+    // Helpers claim indices one at a time, so a slow index never holds up
+    // the rest. Whoever has nothing better to do picks them up.
+    size_t helpers = std::min(count - 1, workers.size());
+    for(size_t i = 0; i < helpers; i++)
+    {
+        push([state] { state->run(); });
+    }
+
+    state->run();
+
+    // Threads outside the pool only wait for their own loop. Other work in
+    // the shared queue can be a whole conversion for another thread, and
+    // the window would freeze until it was done.
+    if(current_pool != this)
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&] { return state->finished.load() == count; });
+        return;
+    }
+
+    // Help out with other work until the last index finishes elsewhere
+    while(state->finished.load() < count)
+    {
+        if(runOneTask()) { continue; }
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&] {
+            return state->finished.load() == count || pending_tasks.load() != 0;
+        });
+    }
+}
+
+
+
+void ThreadPool::push(std::function<void()> task)
+{
+    size_t queue = (current_pool == this) ? current_queue : queues.size() - 1;
+
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        pending_tasks.fetch_add(1);
+    }
+    wake.notify_one();
+}
+
+
+
+bool ThreadPool::runOneTask()
+{
+    if(pending_tasks.load() == 0) { return false; }
+
+    size_t own = (current_pool == this) ? current_queue : queues.size() - 1;
+    std::function<void()> task;
+
+    // Newest from our own queue first, since it is most likely still in
+    // cache. Then steal the oldest work from everyone else.
+    for(size_t i = 0; i < queues.size() && !task; i++)
+    {
+        size_t victim = (own + i) % queues.size();
+        std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+        std::deque<std::function<void()>>& tasks = queues[victim]->tasks;
+        if(tasks.empty()) { continue; }
+
+        if(i == 0)
+        {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+        } else
+        {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+    }
+
+    if(!task) { return false; }
+
+    pending_tasks.fetch_sub(1);
+    task();
+    return true;
+}
+
+
+
+void ThreadPool::workerLoop(size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+
+    while(true)
+    {
+        if(runOneTask()) { continue; }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this] { return stopping || pending_tasks.load() != 0; });
+        if(stopping) { return; }
+    }
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+ * @file    src/thread_pool.hpp
+ * @project ColorTestSDL2
+ * @brief   Work-stealing worker pool for splitting pixel loops across cores
+ * @author  ImpendingMoon
+ * @created 10/15/2026
+ ******************************************************************************/
+
+
+
+#ifndef COLORTESTSDL2_THREAD_POOL_HPP
+#define COLORTESTSDL2_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Each worker has its own task queue, and steals from the others when
+ * it runs dry. parallelFor can be nested: a file-level loop can run tile-level
+ * loops, and idle workers pick up tiles from whichever image is still busy.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param thread_count Total threads, including the caller of parallelFor.
+     * 0 uses one per hardware thread.
+     */
+    explicit ThreadPool(unsigned thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    /**
+     * @brief Runs task(0) to task(count - 1) across the pool, and returns once
+     * all of them have finished. The calling thread helps, so this may be
+     * called from inside another task. Workers also run other queued work
+     * while they wait, but threads outside the pool only run their own loop.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(size_t index);
+    void push(std::function<void()> task);
+    bool runOneTask();
+
+    std::vector<std::thread> workers;
+
+    // One queue per worker, plus one for threads outside the pool
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<size_t> pending_tasks{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+// Set from another thread to stop a job early. Long loops check it once per
+// tile, so a job that is no longer wanted gives its threads back quickly.
+using CancelToken = std::atomic<bool>;
+
+/**
+ * @brief Whether a job has been cancelled. A null token never is.
+ */
+inline bool isCancelled(const CancelToken* cancel)
+{
+    return cancel != nullptr && cancel->load(std::memory_order_relaxed);
+}
+
+#endif //COLORTESTSDL2_THREAD_POOL_HPP